@@ -20,6 +20,7 @@ namespace budget {
 
 struct data_reader;
 struct data_writer;
+struct completion_index;
 
 struct accounts_module {
     void load();
@@ -54,6 +55,12 @@ bool account_exists(const std::string& account);
 
 std::vector<std::string> all_account_names();
 
+/*!
+ * \brief Return the names of the active accounts for completion, ranked by
+ * the given number of uses of each account id.
+ */
+completion_index account_names_completion(const std::map<size_t, size_t>& uses);
+
 struct data_cache;
 
 std::vector<budget::account> all_accounts();
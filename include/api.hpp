@@ -7,18 +7,49 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 #include <utility>
 #include <map>
+#include <vector>
 
 namespace budget {
 
 struct api_response {
     bool success;
     std::string result;
+    int status = 0; // The HTTP status, 0 if there was no response
 };
 
+using api_params = std::map<std::string, std::string, std::less<>>;
+using api_line_receiver = std::function<void(const std::string&)>;
+
 api_response api_get(const std::string& api);
-api_response api_post(const std::string& api, const std::map<std::string, std::string, std::less<>>& params);
+api_response api_post(const std::string& api, const api_params& params);
+
+/*!
+ * \brief Post with a gzip compressed body, when compression is enabled.
+ *
+ * If the server does not support compressed requests, the request is sent
+ * again without compression.
+ */
+api_response api_post_compressed(const std::string& api, const api_params& params);
+
+/*!
+ * \brief Get a text resource, line by line.
+ *
+ * Each line of the response is given to the receiver as soon as it arrives,
+ * the result of the response stays empty. An exception thrown by the receiver
+ * cancels the request and is propagated to the caller.
+ */
+api_response api_get_lines(const std::string& api, const api_line_receiver& receiver);
+
+/*!
+ * \brief Post several entries in a single request.
+ *
+ * The parameters of the i-th entry are sent with a entry{i}_ prefix, along
+ * with the number of entries in input_count.
+ */
+api_response api_post_many(const std::string& api, const std::vector<api_params>& entries);
 
 } //end of namespace budget
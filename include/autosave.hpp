@@ -0,0 +1,44 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <functional>
+
+namespace budget {
+
+/*!
+ * \brief Schedule the save of a changed module.
+ *
+ * The save is run by a background saver at most autosave_delay milliseconds
+ * later. Several changes of the same owner before the save are coalesced
+ * into a single save.
+ *
+ * \return false if the saver has been stopped, in which case the caller must
+ * save by itself.
+ */
+bool schedule_save(const void* owner, std::function<void()> save);
+
+/*!
+ * \brief Forget the scheduled save of an owner, waiting for the save if it is
+ * currently running.
+ */
+void cancel_save(const void* owner);
+
+/*!
+ * \brief Run all the scheduled saves now, in the calling thread.
+ */
+void flush_saves();
+
+/*!
+ * \brief Stop the background saver, after running all the scheduled saves.
+ *
+ * This is also done automatically at exit.
+ */
+void stop_autosave();
+
+} //end of namespace budget
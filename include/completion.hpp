@@ -0,0 +1,68 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace budget {
+
+/*!
+ * \brief The choices of a prompt, indexed for prefix completion.
+ *
+ * The choices are sorted once, with and without case, so that the choices
+ * starting with a prefix are found by binary search rather than by testing
+ * every choice. The results are ranked by the number of uses of each
+ * choice, the most used first.
+ */
+struct completion_index {
+    completion_index() = default;
+
+    /*!
+     * \brief Index the given choices, uses[i] being the number of uses of
+     * choices[i]. Without uses, the choices keep their order.
+     */
+    explicit completion_index(std::vector<std::string> choices, const std::vector<size_t>& uses = {});
+
+    /*!
+     * \brief Return the choices starting with the given prefix, ranked.
+     */
+    std::vector<std::string_view> complete(std::string_view prefix) const;
+
+    /*!
+     * \brief Return the choices starting with the given prefix, ignoring
+     * case, ranked.
+     */
+    std::vector<std::string_view> complete_icase(std::string_view prefix) const;
+
+    /*!
+     * \brief Return the ranked choice at the given position.
+     */
+    const std::string& operator[](size_t i) const {
+        return choices_[i];
+    }
+
+    size_t size() const {
+        return choices_.size();
+    }
+
+    bool empty() const {
+        return choices_.empty();
+    }
+
+private:
+    std::vector<std::string_view> collect(const std::vector<size_t>& sorted, const std::vector<std::string>& keys, std::string_view prefix) const;
+
+    std::vector<std::string> choices_; ///< The choices, ranked
+    std::vector<std::string> lower_;   ///< The lowercased choices, ranked
+    std::vector<size_t>      sorted_;  ///< The ranks of the choices, in the order of the choices
+    std::vector<size_t>      isorted_; ///< The ranks of the choices, in the order of the lowercased choices
+};
+
+} //end of namespace budget
@@ -23,6 +23,20 @@ std::filesystem::path path_to_home_file(std::string_view file);
 std::filesystem::path path_to_budget_file(std::string_view file);
 
 bool load_config();
+
+/*!
+ * \brief Reload the global configuration file, without checking the data
+ * directory nor loading the internal configuration.
+ */
+void reload_config();
+
+/*!
+ * \brief Return the generation of the configuration. It changes each time the
+ * configuration is loaded or changed, so that the values derived from the
+ * configuration know when to read it again.
+ */
+size_t config_generation();
+
 void save_config();
 
 bool config_contains(std::string_view key);
@@ -66,6 +80,11 @@ bool is_server_mode();
  */
 bool is_server_ssl();
 
+/*!
+ * \brief Indicates if the transfers with the server should be compressed.
+ */
+bool is_server_compression();
+
 /*!
  * \brief Indicates if the fortune module is disabled.
  */
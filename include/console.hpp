@@ -15,6 +15,7 @@
 #include "money.hpp"
 #include "date.hpp"
 #include "data_cache.hpp"
+#include "completion.hpp"
 
 namespace budget {
 
@@ -121,9 +122,10 @@ bool check(const T& value, CheckerA first, Checker... checkers){
 }
 
 std::string get_string_complete(const std::vector<std::string>& choices);
+std::string get_string_complete(const completion_index& choices);
 
 template<typename ...Checker>
-void edit_string_complete(std::string& ref, std::string_view title, const std::vector<std::string>& choices, Checker... checkers){
+void edit_string_complete(std::string& ref, std::string_view title, const completion_index& choices, Checker... checkers){
     bool checked = false;
     do {
         std::cout << title << " [" << ref << "]: ";
@@ -138,6 +140,11 @@ void edit_string_complete(std::string& ref, std::string_view title, const std::v
     } while(!checked);
 }
 
+template<typename ...Checker>
+void edit_string_complete(std::string& ref, std::string_view title, const std::vector<std::string>& choices, Checker... checkers){
+    edit_string_complete(ref, title, completion_index(choices), checkers...);
+}
+
 template<typename ...Checker>
 void edit_string(std::string& ref, std::string_view title, Checker... checkers){
     bool checked = false;
@@ -7,19 +7,57 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+
+#include "negative_cache.hpp"
 
 namespace budget {
 
 struct date;
 
+/*!
+ * \brief A currency code interned to the small id under which its rates are
+ * stored.
+ */
+using currency_id = uint16_t;
+
+/*!
+ * \brief Resolve a currency code to its id, once, so that a series of
+ * conversions do not have to hash the code again.
+ */
+currency_id resolve_currency(std::string_view currency);
+
+/*!
+ * \brief Return the id of the default currency. The configuration is only
+ * read again once it has been reloaded.
+ */
+currency_id resolve_default_currency();
+
 double exchange_rate(const std::string& from);
 double exchange_rate(const std::string& from, const budget::date& d);
 double exchange_rate(const std::string& from, const std::string& to);
 double exchange_rate(const std::string& from, const std::string& to, const budget::date& d);
+double exchange_rate(currency_id from, currency_id to, const budget::date& d);
 
 void load_currency_cache();
 void save_currency_cache();
+
+cache_stats currency_cache_stats();
+
+/*!
+ * \brief Refresh the latest rates of the currencies in use in the background.
+ *
+ * This returns immediately. The refresh is skipped if one is already
+ * running or if the last one started less than currency_refresh_interval
+ * minutes ago.
+ */
 void refresh_currency_cache();
 
+/*!
+ * \brief Stop the background refresh and wait for it to finish.
+ */
+void stop_currency_cache_refresh();
+
 } //end of namespace budget
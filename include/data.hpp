@@ -11,6 +11,9 @@
 #include <string>
 #include <vector>
 #include <atomic>
+#include <initializer_list>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "cpp_utils/assert.hpp"
 
@@ -20,6 +23,8 @@
 #include "api.hpp"
 #include "server_lock.hpp"
 #include "budget_exception.hpp"
+#include "autosave.hpp"
+#include "listing.hpp"
 
 namespace budget {
 
@@ -70,6 +75,12 @@ struct data_handler {
         // Nothing else to init
     };
 
+    ~data_handler() {
+        if (is_server_running()) {
+            cancel_save(this);
+        }
+    }
+
     //data_handler should never be copied
     data_handler(const data_handler& rhs) = delete;
     data_handler& operator=(const data_handler& rhs) = delete;
@@ -78,6 +89,12 @@ struct data_handler {
         return changed;
     }
 
+    // Incremented on each change of the data, even the ones that are not
+    // saved, so that anything derived from the data knows when to rebuild
+    size_t revision() const {
+        return revision_;
+    }
+
     void set_changed() {
         server_lock_guard l(lock);
 
@@ -94,18 +111,7 @@ struct data_handler {
                 continue;
             }
 
-            data_reader reader;
-            reader.parse(line);
-
-            T entry;
-
-            f(reader, entry);
-
-            if (entry.id >= next_id) {
-                next_id = entry.id + 1;
-            }
-
-            data_.push_back(std::move(entry));
+            parse_entry(line, f);
         }
     }
 
@@ -116,12 +122,7 @@ struct data_handler {
         data_.clear();
 
         if(is_server_mode()){
-            auto res = budget::api_get(std::string("/") + module + "/list/");
-
-            if(res.success){
-                std::stringstream ss(res.result);
-                parse_stream(ss, f);
-            }
+            load_from_server(f);
         } else {
             auto file_path = path_to_budget_file(path);
 
@@ -142,6 +143,8 @@ struct data_handler {
                 }
             }
         }
+
+        ++revision_;
     }
 
     void load(){
@@ -157,7 +160,10 @@ struct data_handler {
             return;
         }
 
-        // In other modes, save if it's changed
+        // In other modes, save if it's changed. While the server is running,
+        // the background saver may be saving at the same time
+        server_lock_guard l(lock);
+
         if (is_changed()) {
             force_save();
         }
@@ -166,6 +172,226 @@ struct data_handler {
     bool indirect_edit(const T& value, bool propagate = true) {
         server_lock_guard l(lock);
 
+        return edit_unlocked(value, propagate);
+    }
+
+    template <typename TT>
+    size_t add(TT&& entry) {
+        server_lock_guard l(lock);
+
+        return add_unlocked(std::forward<TT>(entry), true);
+    }
+
+    // Add several entries at once. In server mode, they are all sent in a
+    // single request. The id of an entry that could not be added is 0
+    std::vector<size_t> add_many(std::vector<T>&& entries) {
+        std::vector<size_t> ids;
+        ids.reserve(entries.size());
+
+        if (entries.empty()) {
+            return ids;
+        }
+
+        server_lock_guard l(lock);
+
+        if (is_server_mode()) {
+            std::vector<api_params> params;
+            params.reserve(entries.size());
+
+            for (auto& entry : entries) {
+                params.emplace_back(entry.get_params());
+            }
+
+            auto res = budget::api_post_many(std::string("/") + get_module() + "/add/many/", params);
+
+            // Older servers do not support adding several entries at once
+            if (res.status == 404) {
+                for (auto& entry : entries) {
+                    ids.push_back(add_unlocked(std::move(entry), true));
+                }
+
+                return ids;
+            }
+
+            auto result_ids = split(res.result, ',');
+
+            if (!res.success || result_ids.size() != entries.size()) {
+                LOG_F(ERROR, "Failed to add {} entries to module {}", entries.size(), get_module());
+
+                ids.resize(entries.size(), 0);
+                return ids;
+            }
+
+            for (size_t i = 0; i < entries.size(); ++i) {
+                entries[i].id = budget::to_number<size_t>(result_ids[i]);
+                ids.push_back(entries[i].id);
+
+                data_.emplace_back(std::move(entries[i]));
+            }
+
+            ++revision_;
+
+            return ids;
+        }
+
+        for (auto& entry : entries) {
+            entry.id = next_id++;
+            ids.push_back(entry.id);
+
+            data_.emplace_back(std::move(entry));
+        }
+
+        ++revision_;
+
+        set_changed_internal();
+
+        return ids;
+    }
+
+    bool remove(size_t id) {
+        server_lock_guard l(lock);
+
+        return remove_unlocked(id, true);
+    }
+
+    bool exists(size_t id) {
+        server_lock_guard l(lock);
+
+        return std::ranges::any_of(data_, [id](const auto & entry) { return entry.id == id; });
+    }
+
+    T operator[](size_t id) const {
+        server_lock_guard l(lock);
+
+        for (auto& value : data_) {
+            if (value.id == id) {
+                return value;
+            }
+        }
+
+        throw budget_exception(std::format("There is no data with id {} in {}", id, module));
+    }
+
+    size_t size() const {
+        server_lock_guard l(lock);
+        return data_.size();
+    }
+
+    bool empty() const {
+        server_lock_guard l(lock);
+        return data_.empty();
+    }
+
+    const char* get_module() const {
+        return module;
+    }
+
+    std::vector<T> data() const {
+        std::vector<T> copy;
+        copy.reserve(size());
+
+        {
+            server_lock_guard l(lock);
+            std::ranges::copy(data_, std::back_inserter(copy));
+        }
+
+        return copy;
+    }
+
+    // Only the entries of the window are copied, newest first
+    std::vector<T> window(const listing_window& window) const {
+        std::vector<T> copy;
+
+        {
+            server_lock_guard l(lock);
+
+            for (const T* entry : select_window(data_, window)) {
+                copy.push_back(*entry);
+            }
+        }
+
+        return copy;
+    }
+
+    // A group of mutations applied as a single unit. The lock is held for the
+    // whole batch and the data is only marked as changed (and saved, when the
+    // server is running) once, on commit. A batch that is not committed, for
+    // instance because of an exception, restores the data as it was before
+    // the batch. In server mode, the mutations are sent as they are made and
+    // cannot be rolled back.
+    //
+    // The handler must not be used directly while a batch is open.
+    struct batch {
+        explicit batch(data_handler& handler) : handler(handler), guard(handler.lock) {
+            if (!is_server_mode()) {
+                backup         = handler.data_;
+                backup_next_id = handler.next_id;
+            }
+        }
+
+        batch(const batch& rhs) = delete;
+        batch& operator=(const batch& rhs) = delete;
+
+        ~batch() {
+            if (!committed && !is_server_mode()) {
+                handler.data_   = std::move(backup);
+                handler.next_id = backup_next_id;
+                ++handler.revision_;
+            }
+        }
+
+        template <typename TT>
+        size_t add(TT&& entry) {
+            changed = true;
+
+            return handler.add_unlocked(std::forward<TT>(entry), false);
+        }
+
+        bool edit(const T& value) {
+            const bool edited = handler.edit_unlocked(value, false);
+
+            changed |= edited;
+
+            return edited;
+        }
+
+        bool remove(size_t id) {
+            const bool removed = handler.remove_unlocked(id, false);
+
+            changed |= removed;
+
+            return removed;
+        }
+
+        void commit() {
+            committed = true;
+
+            if (changed && !is_server_mode()) {
+                handler.set_changed_internal();
+            }
+        }
+
+    private:
+        data_handler& handler;
+        server_lock_guard guard;
+        std::vector<T> backup;
+        size_t backup_next_id = 0;
+        bool changed          = false;
+        bool committed        = false;
+    };
+
+    batch begin_batch() {
+        return batch(*this);
+    }
+
+    // This can only be accessed during loading
+    std::vector<T> & unsafe_data() {
+        ++revision_;
+        return data_;
+    }
+
+private:
+    bool edit_unlocked(const T& value, bool propagate) {
         if (is_server_mode()) {
             auto params = value.get_params();
 
@@ -181,6 +407,7 @@ struct data_handler {
         for (auto& v : data_) {
             if (v.id == value.id) {
                 v = value;
+                ++revision_;
 
                 if (propagate) {
                     set_changed_internal();
@@ -194,9 +421,7 @@ struct data_handler {
     }
 
     template <typename TT>
-    size_t add(TT&& entry) {
-        server_lock_guard l(lock);
-
+    size_t add_unlocked(TT&& entry, bool propagate) {
         if (is_server_mode()) {
             auto params = entry.get_params();
 
@@ -216,18 +441,22 @@ struct data_handler {
 
             data_.emplace_back(std::forward<TT>(entry));
 
-            set_changed_internal();
+            if (propagate) {
+                set_changed_internal();
+            }
         }
 
+        ++revision_;
+
         return entry.id;
     }
 
-    bool remove(size_t id) {
-        server_lock_guard l(lock);
-
-        auto before = data_.size();
+    bool remove_unlocked(size_t id, bool propagate) {
+        const bool removed = std::erase_if(data_, [id](const T& entry) { return entry.id == id; }) > 0;
 
-        std::erase_if(data_, [id](const T& entry) { return entry.id == id; });
+        if (removed) {
+            ++revision_;
+        }
 
         if (is_server_mode()) {
             auto res = budget::api_get(std::format("/{}/delete/?input_id={}", get_module(), id));
@@ -238,66 +467,213 @@ struct data_handler {
 
             return res.success;
         }
-        set_changed_internal();
 
-        return data_.size() < before;
+        if (propagate && removed) {
+            set_changed_internal();
+        }
+
+        return removed;
     }
 
-    bool exists(size_t id) {
-        server_lock_guard l(lock);
+    // In server mode, a local replica of the module is kept in the budget
+    // folder, along with the version of the server it corresponds to. Only
+    // the changes since that version are downloaded.
+    //
+    // The changes are answered by /<module>/list/since/?version=<version>:
+    // the first line is the new version, followed by :full if the replica
+    // must be cleared first, then one line per change, either +<entry> for
+    // an added or edited entry or -<id> for a removed entry.
+    template<typename Functor>
+    void load_from_server(Functor f){
+        const auto replica_path = path_to_budget_file(std::string(path) + ".replica");
+
+        // Load the replica, returning its version
+        auto load_replica = [&]() -> size_t {
+            data_.clear();
+            next_id = 1;
+
+            if (std::ifstream replica(replica_path); replica.is_open() && replica.good()) {
+                std::string version_line;
+                getline(replica, version_line);
+
+                try {
+                    auto replica_version = budget::to_number<size_t>(version_line);
+                    parse_stream(replica, f);
+                    return replica_version;
+                } catch (const budget_exception&) {
+                    LOG_F(ERROR, "Invalid replica for module {}, downloading it again", get_module());
+
+                    data_.clear();
+                    next_id = 1;
+                }
+            }
 
-        return std::ranges::any_of(data_, [id](const auto & entry) { return entry.id == id; });
-    }
+            return 0;
+        };
 
-    T operator[](size_t id) const {
-        server_lock_guard l(lock);
+        // When the changes cannot be downloaded, the replica is used as is
+        auto fall_back = [&]() {
+            if (load_replica()) {
+                LOG_F(ERROR, "Using the replica of module {}", get_module());
+            }
+        };
 
-        for (auto& value : data_) {
-            if (value.id == id) {
-                return value;
+        const size_t version = load_replica();
+
+        // The changes are parsed as the lines arrive, the response is never
+        // stored as a whole
+        size_t new_version = version;
+        bool header        = true;
+
+        // The removals are applied at the end, an entry added again after its
+        // removal is kept
+        std::unordered_map<size_t, size_t> indexes;
+        std::unordered_set<size_t> removed;
+
+        auto receiver = [&](const std::string& line) {
+            if (header) {
+                header = false;
+
+                auto header_parts = split(line, ':');
+
+                if (header_parts.empty()) {
+                    throw budget_exception("missing version");
+                }
+
+                new_version = budget::to_number<size_t>(header_parts[0]);
+
+                if (header_parts.size() > 1 && header_parts[1] == "full") {
+                    data_.clear();
+                }
+
+                for (size_t i = 0; i < data_.size(); ++i) {
+                    indexes[data_[i].id] = i;
+                }
+
+                return;
+            }
+
+            if (line.size() < 2) {
+                return;
+            }
+
+            if (line[0] == '-') {
+                removed.insert(budget::to_number<size_t>(std::string_view(line).substr(1)));
+            } else if (line[0] == '+') {
+                data_reader reader;
+                reader.parse(line.substr(1));
+
+                T entry;
+                f(reader, entry);
+
+                removed.erase(entry.id);
+
+                if (auto it = indexes.find(entry.id); it != indexes.end()) {
+                    data_[it->second] = std::move(entry);
+                } else {
+                    indexes[entry.id] = data_.size();
+                    data_.push_back(std::move(entry));
+                }
             }
+        };
+
+        api_response res;
+
+        try {
+            res = budget::api_get_lines(std::format("/{}/list/since/?version={}", get_module(), version), receiver);
+        } catch (const budget_exception& e) {
+            LOG_F(ERROR, "Invalid changes for module {}: {}", get_module(), e.message());
+
+            fall_back();
+            return;
         }
 
-        throw budget_exception(std::format("There is no data with id {} in {}", id, module));
-    }
+        // Older servers only support downloading the full list
+        if (res.status == 404) {
+            data_.clear();
+            next_id = 1;
 
-    size_t size() const {
-        server_lock_guard l(lock);
-        return data_.size();
-    }
+            try {
+                res = budget::api_get_lines(std::string("/") + module + "/list/", [&](const std::string& line) {
+                    if (!line.empty()) {
+                        parse_entry(line, f);
+                    }
+                });
+            } catch (const budget_exception& e) {
+                LOG_F(ERROR, "Invalid list for module {}: {}", get_module(), e.message());
 
-    bool empty() const {
-        server_lock_guard l(lock);
-        return data_.empty();
-    }
+                fall_back();
+                return;
+            }
 
-    const char* get_module() const {
-        return module;
-    }
+            if (!res.success) {
+                fall_back();
+            }
 
-    std::vector<T> data() const {
-        std::vector<T> copy;
-        copy.reserve(size());
+            return;
+        }
 
-        {
-            server_lock_guard l(lock);
-            std::ranges::copy(data_, std::back_inserter(copy));
+        if (!res.success || header) {
+            fall_back();
+            return;
         }
 
-        return copy;
+        if (!removed.empty()) {
+            std::erase_if(data_, [&removed](const T& entry) { return removed.contains(entry.id); });
+        }
+
+        next_id = 1;
+        for (auto& entry : data_) {
+            next_id = std::max(next_id, entry.id + 1);
+        }
+
+        if (new_version != version) {
+            std::ofstream replica(replica_path);
+
+            replica << new_version << std::endl;
+
+            for (auto& entry : data_) {
+                data_writer writer;
+                entry.save(writer);
+                replica << writer.to_string() << std::endl;
+            }
+        }
     }
 
-    // This can only be accessed during loading
-    std::vector<T> & unsafe_data() {
-        return data_;
+    template<typename Functor>
+    void parse_entry(const std::string& line, Functor& f) {
+        data_reader reader;
+        reader.parse(line);
+
+        T entry;
+
+        f(reader, entry);
+
+        if (entry.id >= next_id) {
+            next_id = entry.id + 1;
+        }
+
+        data_.push_back(std::move(entry));
     }
 
-private:
+    // When the server is running, the changes are saved in the background,
+    // several changes being coalesced into a single save
     void set_changed_internal() {
+        changed = true;
+
         if (is_server_running()) {
-            force_save();
-        } else {
-            changed = true;
+            auto scheduled = schedule_save(this, [this]() {
+                server_lock_guard l(lock);
+
+                if (changed) {
+                    force_save();
+                }
+            });
+
+            // During shutdown, the save is done right away
+            if (!scheduled) {
+                force_save();
+            }
         }
     }
 
@@ -332,10 +708,20 @@ private:
     const char* module;
     const char* path;
     std::atomic<bool> changed = false;
+    std::atomic<size_t> revision_ = 0;
     mutable server_lock lock;
     std::vector<T> data_;
 };
 
 bool migrate_database(size_t old_data_version);
 
+/*!
+ * \brief Load several modules at once.
+ *
+ * In server mode, the modules are downloaded concurrently and each of them is
+ * parsed as soon as its own response arrives. Otherwise, they are simply
+ * loaded one after another from the local files.
+ */
+void load_concurrently(std::initializer_list<void (*)()> loaders);
+
 } //end of namespace budget
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <mutex>
 #include <vector>
 
 #include "earnings.hpp"
@@ -20,8 +21,11 @@
 #include "objectives.hpp"
 #include "expenses.hpp"
 #include "wishes.hpp"
+#include "currency.hpp"
 #include <unordered_map>
 
+#include "cpp_utils/hash.hpp"
+
 namespace budget {
 
 struct data_cache {
@@ -47,6 +51,12 @@ struct data_cache {
     std::vector<asset> & active_user_assets();
     std::vector<wish> & wishes();
 
+    // The currencies of the assets and of the liabilities, and the default
+    // currency, are resolved to their ids once per cache. Any other currency
+    // is resolved on each call.
+    currency_id currency(std::string_view code);
+    currency_id default_currency();
+
     data_cache() = default;
 
     // No point in copying that
@@ -54,6 +64,8 @@ struct data_cache {
     data_cache & operator=(const data_cache & cache) = delete;
 
 private:
+    void resolve_currencies();
+
     std::vector<earning> earnings_;
     std::vector<earning> sorted_earnings_;
     std::vector<debt> debts_;
@@ -76,6 +88,33 @@ private:
     std::vector<asset> user_assets_;
     std::vector<asset> active_user_assets_;
     std::vector<wish> wishes_;
+    cpp::string_hash_map<currency_id> currencies_;
+    currency_id default_currency_ = 0;
+
+    // Each part of the cache is filled once, even with concurrent readers
+    std::once_flag earnings_flag_;
+    std::once_flag sorted_earnings_flag_;
+    std::once_flag debts_flag_;
+    std::once_flag fortunes_flag_;
+    std::once_flag asset_values_flag_;
+    std::once_flag sorted_asset_values_flag_;
+    std::once_flag sorted_group_asset_values_flag_;
+    std::once_flag sorted_group_asset_values_liabilities_flag_;
+    std::once_flag liabilities_flag_;
+    std::once_flag recurrings_flag_;
+    std::once_flag incomes_flag_;
+    std::once_flag accounts_flag_;
+    std::once_flag asset_shares_flag_;
+    std::once_flag sorted_asset_shares_flag_;
+    std::once_flag asset_classes_flag_;
+    std::once_flag objectives_flag_;
+    std::once_flag expenses_flag_;
+    std::once_flag sorted_expenses_flag_;
+    std::once_flag assets_flag_;
+    std::once_flag user_assets_flag_;
+    std::once_flag active_user_assets_flag_;
+    std::once_flag wishes_flag_;
+    std::once_flag currencies_flag_;
 };
 
 // Filter functions
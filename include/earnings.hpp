@@ -21,6 +21,7 @@ namespace budget {
 
 struct data_reader;
 struct data_writer;
+struct listing_window;
 
 struct earnings_module {
     void load();
@@ -53,7 +54,9 @@ void save_earnings();
 
 std::vector<earning> all_earnings();
 size_t add_earning(earning&& earning);
+std::vector<size_t> add_earnings(std::vector<earning>&& earnings);
 bool edit_earning(const earning& earning);
+void edit_earnings(const std::vector<earning>& earnings);
 
 void set_earnings_changed();
 
@@ -62,6 +65,7 @@ void earning_delete(size_t id);
 earning earning_get(size_t id);
 
 void show_all_earnings(budget::writer& w);
+void show_all_earnings(const listing_window& window, budget::writer& w);
 void show_earnings(budget::month month, budget::year year, budget::writer& w);
 void show_earnings(budget::month month, budget::writer& w);
 void show_earnings(budget::writer& w);
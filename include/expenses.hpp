@@ -21,6 +21,7 @@ namespace budget {
 
 struct data_reader;
 struct data_writer;
+struct listing_window;
 
 const date TEMPLATE_DATE(1666, 6, 6);
 
@@ -65,7 +66,9 @@ void save_expenses();
 
 std::vector<expense> all_expenses();
 size_t add_expense(expense&& expense);
+std::vector<size_t> add_expenses(std::vector<expense>&& expenses);
 bool edit_expense(const expense& expense);
+void edit_expenses(const std::vector<expense>& expenses);
 
 void set_expenses_changed();
 
@@ -74,6 +77,7 @@ void expense_delete(size_t id);
 expense expense_get(size_t id);
 
 void show_all_expenses(budget::writer& w);
+void show_all_expenses(const listing_window& window, budget::writer& w);
 void show_expenses(budget::month month, budget::year year, budget::writer& w);
 void show_expenses(budget::month month, budget::writer& w);
 void show_expenses(budget::writer& w);
@@ -0,0 +1,75 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "date.hpp"
+
+namespace budget {
+
+/*!
+ * \brief The rows of a listing to display, newest first.
+ */
+struct listing_window {
+    size_t                      limit  = 0; ///< The maximum number of rows, 0 for all of them
+    size_t                      offset = 0; ///< The number of newest rows to skip
+    std::optional<budget::date> since;      ///< Only display the rows from this date on
+
+    /*!
+     * \brief Indicates if any of the options was given
+     */
+    bool is_windowed() const {
+        return limit || offset || since;
+    }
+};
+
+/*!
+ * \brief Extract the --limit=, --offset= and --since= options from the given
+ * arguments.
+ */
+listing_window listing_window_option(std::vector<std::string>& args);
+
+/*!
+ * \brief Select the entries of the given window, newest first.
+ *
+ * Only the entries that end up in the window are sorted, the other ones are
+ * only filtered by date, so that selecting a few rows out of a large ledger
+ * is linear and only the visible rows need to be copied and formatted.
+ */
+template <typename T>
+std::vector<const T*> select_window(const std::vector<T>& entries, const listing_window& window) {
+    std::vector<const T*> selected;
+    selected.reserve(entries.size());
+
+    for (const auto& entry : entries) {
+        if (!window.since || entry.date >= *window.since) {
+            selected.push_back(&entry);
+        }
+    }
+
+    auto newer = [](const T* lhs, const T* rhs) {
+        return std::tie(lhs->date, lhs->id) > std::tie(rhs->date, rhs->id);
+    };
+
+    const size_t first = std::min(window.offset, selected.size());
+    const size_t last  = window.limit ? std::min(window.offset + window.limit, selected.size()) : selected.size();
+
+    std::ranges::partial_sort(selected, selected.begin() + last, newer);
+
+    selected.erase(selected.begin() + last, selected.end());
+    selected.erase(selected.begin(), selected.begin() + first);
+
+    return selected;
+}
+
+} //end of namespace budget
@@ -0,0 +1,42 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+namespace budget {
+
+struct date;
+
+/*!
+ * \brief Indicates if the market is open on the given day.
+ *
+ * The market is closed on weekends and on the holidays configured with
+ * market_holidays, a comma-separated list of dates (2024-12-25) or of
+ * yearly holidays (12-25).
+ */
+bool is_trading_day(const budget::date& d);
+
+/*!
+ * \brief Returns the last trading day on or before the given day.
+ */
+budget::date last_trading_day(const budget::date& d);
+
+/*!
+ * \brief Returns the last trading day whose closing price is known.
+ *
+ * This is only computed once per minute, so that callers do not have to
+ * look at the clock and the time zone on each lookup.
+ */
+budget::date last_closed_trading_day();
+
+/*!
+ * \brief Returns the trading day whose closing price should be used for the
+ * given day.
+ */
+budget::date valid_trading_day(const budget::date& d);
+
+} //end of namespace budget
@@ -0,0 +1,66 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <string>
+#include <atomic>
+
+#include "cpp_utils/hash.hpp"
+
+#include "server_lock.hpp"
+
+namespace budget {
+
+// Counters of the lookups into a cache
+struct cache_stats {
+    size_t hits;          // Found in the cache
+    size_t misses;        // Fetched from the provider
+    size_t negative_hits; // Not fetched because of a recent failure
+};
+
+struct cache_counters {
+    std::atomic<size_t> hits          = 0;
+    std::atomic<size_t> misses        = 0;
+    std::atomic<size_t> negative_hits = 0;
+
+    cache_stats stats() const {
+        return {hits.load(), misses.load(), negative_hits.load()};
+    }
+};
+
+/*!
+ * \brief A persisted cache of the keys whose lookup recently failed.
+ *
+ * After a failure, a key is negative until its entry expires. The delay
+ * doubles with each consecutive failure of the key, starting from
+ * negative_cache_delay minutes (60 by default), up to seven days. An entry
+ * expired for more than seven days is dropped when loading or saving.
+ */
+struct negative_cache {
+    explicit negative_cache(const char* path) : path(path) {}
+
+    void load();
+    void save();
+
+    bool contains(std::string_view key);
+    void failure(std::string_view key);
+    void success(std::string_view key);
+
+private:
+    struct entry {
+        int64_t expiry;  // In seconds since epoch
+        size_t failures;
+    };
+
+    const char* path;
+    bool changed = false;
+    server_lock lock;
+    cpp::string_hash_map<entry> entries;
+};
+
+} //end of namespace budget
@@ -0,0 +1,67 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace budget {
+
+/*!
+ * \brief Compute functor(i) for each i in [0, tasks) on a pool of threads.
+ *
+ * At most one thread per core is used, each of them taking the next task
+ * until all of them are done. The results are returned in the order of the
+ * tasks, the first exception thrown by a task is rethrown once all the
+ * threads are done.
+ */
+template <typename Functor>
+auto parallel_map(size_t tasks, Functor&& functor) {
+    using result_type = std::invoke_result_t<Functor&, size_t>;
+
+    std::vector<result_type> results(tasks);
+
+    const size_t workers = std::min<size_t>(tasks, std::max(1U, std::thread::hardware_concurrency()));
+
+    if (workers <= 1) {
+        for (size_t i = 0; i < tasks; ++i) {
+            results[i] = functor(i);
+        }
+
+        return results;
+    }
+
+    std::atomic<size_t> next = 0;
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(workers);
+
+    for (size_t w = 0; w < workers; ++w) {
+        futures.emplace_back(std::async(std::launch::async, [&]() {
+            for (size_t i = next++; i < tasks; i = next++) {
+                results[i] = functor(i);
+            }
+        }));
+    }
+
+    for (auto& future : futures) {
+        future.wait();
+    }
+
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    return results;
+}
+
+} //end of namespace budget
@@ -51,6 +51,12 @@ struct recurring {
 
 void check_for_recurrings();
 
+/*!
+ * \brief Return the first date at which the given recurring will be generated
+ * again, after its last operation at the given date
+ */
+budget::date next_due_date(const recurring& recurring, const budget::date& last);
+
 void load_recurrings();
 void save_recurrings();
 
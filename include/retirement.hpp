@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <optional>
 
 #include "module_traits.hpp"
 #include "writer_fwd.hpp"
@@ -32,6 +35,63 @@ struct module_traits<retirement_module> {
 
 struct asset_value;
 
+/*!
+ * \brief A projection of the net worth, growing each month by a return and
+ * by the savings of the month.
+ *
+ * The net worth after n months has a closed form, the time to reach a target
+ * is computed directly rather than month by month.
+ */
+struct projection {
+    double net_worth;       ///< The net worth at the start
+    double monthly_return;  ///< The return of each month, 0.01 for 1%
+    double monthly_savings; ///< The savings added each month
+
+    /*!
+     * \brief Return the net worth after the given number of months.
+     */
+    double value(size_t months) const;
+
+    /*!
+     * \brief Return the number of months to reach the given net worth, or
+     * nothing if it is never reached.
+     */
+    std::optional<size_t> months_to(double target) const;
+};
+
+/*!
+ * \brief The parameters of a Monte Carlo simulation of the net worth.
+ */
+struct simulation_parameters {
+    double              net_worth       = 0.0;   ///< The net worth at the start
+    double              monthly_savings = 0.0;   ///< The savings added each month
+    double              target          = 0.0;   ///< The net worth to reach
+    double              mean_return     = 0.0;   ///< The mean annual return, 0.05 for 5%
+    double              volatility      = 0.0;   ///< The standard deviation of the annual return
+    std::vector<double> monthly_returns;         ///< When not empty, the monthly returns are drawn from them instead
+    size_t              years           = 30;    ///< The number of simulated years
+    size_t              paths           = 10000; ///< The number of simulated paths
+    uint64_t            seed            = 0;     ///< The seed of the random returns
+};
+
+/*!
+ * \brief The results of a Monte Carlo simulation of the net worth.
+ */
+struct simulation_result {
+    double                               success = 0.0;    ///< The part of the paths reaching the target
+    std::vector<std::array<double, 3>>   net_worth;        ///< The 10th, 50th and 90th percentiles of the net worth at the end of each year
+    std::array<std::optional<size_t>, 3> months_to_target; ///< The 10th, 50th and 90th percentiles of the months to reach the target
+};
+
+/*!
+ * \brief Simulate random paths of the net worth, on several threads.
+ *
+ * The paths are split in fixed chunks, each with its own random generator
+ * seeded from the seed and the chunk, so that the results only depend on the
+ * parameters and not on the number of threads.
+ */
+simulation_result simulate_retirement(const simulation_parameters& parameters);
+
 double fi_ratio(const budget::date & d, data_cache & cache);
 double fixed_fi_ratio(const budget::date & d, data_cache & cache, const money & expenses);
 double fixed_fi_ratio(double wrate, const money & nw, const money & expenses);
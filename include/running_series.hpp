@@ -0,0 +1,86 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <vector>
+
+#include "date.hpp"
+#include "money.hpp"
+
+namespace budget {
+
+struct data_cache;
+
+/*!
+ * \brief The number of months of the running metrics
+ */
+constexpr size_t running_limit = 12;
+
+/*!
+ * \brief The running metrics of each month of a range of months.
+ *
+ * The expenses, earnings and base income are totaled once per month, in a
+ * single pass over the sorted expenses and earnings. The running metrics are
+ * then differences of prefix sums, in constant time per month, instead of
+ * scanning the whole window again for each month.
+ *
+ * The earnings and the base income are only totaled on the first use of the
+ * income or of the savings rate, since many users only need the expenses.
+ * The cache must therefore outlive the series.
+ */
+struct running_series {
+    /*!
+     * \brief Compute the running metrics at first and at the same day of
+     * each following month, until last.
+     */
+    running_series(data_cache& cache, const budget::date& first, const budget::date& last);
+
+    /*!
+     * \brief Return the number of months of the series.
+     */
+    size_t size() const {
+        return dates_.size();
+    }
+
+    /*!
+     * \brief Return the date of the i-th month of the series.
+     */
+    const budget::date& date(size_t i) const {
+        return dates_[i];
+    }
+
+    /*!
+     * \brief Return the persistent expenses of the 13 months before the i-th
+     * month, from the start of the month before the same month of the
+     * previous year to the end of the previous month.
+     */
+    budget::money expenses(size_t i) const;
+
+    /*!
+     * \brief Return the base income and the earnings of the running months
+     * before the i-th month.
+     */
+    budget::money income(size_t i) const;
+
+    /*!
+     * \brief Return the average savings rate of the running months before
+     * the i-th month.
+     */
+    double savings_rate(size_t i) const;
+
+private:
+    void compute_income() const;
+
+    data_cache*                        cache_;
+    std::vector<budget::date>          dates_;
+    std::vector<budget::money>         expenses_;     ///< The prefix sums of the persistent expenses
+    mutable std::vector<budget::money> income_;       ///< The prefix sums of the base income and earnings
+    mutable std::vector<double>        savings_rate_; ///< The prefix sums of the savings rates
+};
+
+} //end of namespace budget
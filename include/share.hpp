@@ -9,6 +9,8 @@
 
 #include <string>
 
+#include "negative_cache.hpp"
+
 namespace budget {
 
 struct date;
@@ -21,4 +23,6 @@ void load_share_price_cache();
 void save_share_price_cache();
 void prefetch_share_price_cache();
 
+cache_stats share_price_cache_stats();
+
 } //end of namespace budget
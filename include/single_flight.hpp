@@ -0,0 +1,63 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <future>
+#include <mutex>
+#include <map>
+
+namespace budget {
+
+/*!
+ * \brief Coalesce concurrent computations of the same key.
+ *
+ * The first caller for a key runs the functor, all the callers arriving
+ * for the same key while it is running wait for its result instead of
+ * running the functor themselves.
+ *
+ * Nothing is cached once the flight has landed, this is only meant to sit
+ * in front of an existing cache.
+ */
+template <typename Key, typename Value>
+struct single_flight {
+    template <typename Functor>
+    Value run(const Key& key, Functor&& functor) {
+        std::unique_lock l(lock);
+
+        if (auto it = flights.find(key); it != flights.end()) {
+            auto flight = it->second;
+            l.unlock();
+
+            return flight.get();
+        }
+
+        std::promise<Value> promise;
+        auto flight = promise.get_future().share();
+        flights.emplace(key, flight);
+
+        l.unlock();
+
+        try {
+            promise.set_value(functor());
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+
+        l.lock();
+        flights.erase(key);
+        l.unlock();
+
+        return flight.get();
+    }
+
+private:
+    std::mutex lock;
+    std::map<Key, std::shared_future<Value>, std::less<>> flights;
+};
+
+} //end of namespace budget
@@ -0,0 +1,50 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace budget {
+
+/*!
+ * \brief An index of texts for case-insensitive substring search.
+ *
+ * Each text is indexed by the trigrams (three consecutive characters) of its
+ * lowercased version. A search only verifies the texts that contain all the
+ * trigrams of the searched string, instead of every text.
+ */
+struct trigram_index {
+    /*!
+     * \brief Add a text to the index, its position is the number of texts
+     * added before it.
+     */
+    void add(std::string_view text);
+
+    /*!
+     * \brief Return the positions of the texts containing the given string,
+     * ignoring case, in increasing order.
+     */
+    std::vector<size_t> search(std::string_view needle) const;
+
+    /*!
+     * \brief Return the number of texts in the index.
+     */
+    size_t size() const {
+        return texts_.size();
+    }
+
+private:
+    std::vector<std::string> texts_; ///< The lowercased texts
+    std::unordered_map<uint32_t, std::vector<size_t>> postings_; ///< The positions of the texts containing each trigram
+};
+
+} //end of namespace budget
@@ -68,6 +68,8 @@ std::vector<std::string> &split(std::string_view s, char delim, std::vector<std:
 std::vector<std::string_view> splitv(std::string_view s, char delim);
 std::vector<std::string_view> &splitv(std::string_view s, char delim, std::vector<std::string_view> &elems);
 
+std::string to_lower(std::string_view text);
+
 std::string base64_decode(std::string_view in);
 std::string base64_encode(std::string_view in);
 
@@ -18,6 +18,7 @@
 #include "config.hpp"
 #include "utils.hpp"
 #include "console.hpp"
+#include "completion.hpp"
 #include "earnings.hpp"
 #include "expenses.hpp"
 #include "writer.hpp"
@@ -112,9 +113,7 @@ std::map<std::string, std::string, std::less<>> budget::account::get_params() co
 }
 
 void budget::accounts_module::load(){
-    load_accounts();
-    load_expenses();
-    load_earnings();
+    load_concurrently({load_accounts, load_expenses, load_earnings});
 }
 
 void budget::accounts_module::unload(){
@@ -141,6 +140,8 @@ void budget::archive_accounts_impl(bool month){
         until_date = since_date - days(1);
     }
 
+    std::vector<budget::account> archived;
+
     for (auto& account : accounts.data() | only_open_ended) {
         budget::account copy;
         copy.guid   = generate_guid();
@@ -154,35 +155,48 @@ void budget::archive_accounts_impl(bool month){
         copies.push_back(std::move(copy));
 
         sources.push_back(account.id);
+        archived.push_back(account);
     }
 
     std::unordered_map<size_t, size_t> mapping;
 
-    for (size_t i = 0; i < copies.size(); ++i) {
-        auto& copy = copies[i];
+    auto ids = accounts.add_many(std::move(copies));
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        mapping[sources[i]] = ids[i];
+    }
+
+    {
+        auto batch = accounts.begin_batch();
 
-        auto id = accounts.add(std::move(copy));
+        for (auto& account : archived) {
+            batch.edit(account);
+        }
 
-        mapping[sources[i]] = id;
+        batch.commit();
     }
 
+    std::vector<budget::expense> moved_expenses;
+
     for (auto& expense : all_expenses() | persistent | since(since_date)) {
         if (mapping.contains(expense.account)) {
             expense.account = mapping[expense.account];
-            indirect_edit_expense(expense, false);
+            moved_expenses.push_back(expense);
         }
     }
 
+    std::vector<budget::earning> moved_earnings;
+
     for (auto& earning : all_earnings() | since(since_date)) {
         if (mapping.contains(earning.account)) {
             earning.account = mapping[earning.account];
-            indirect_edit_earning(earning, false);
+            moved_earnings.push_back(earning);
         }
     }
 
-    set_expenses_changed();
-    set_earnings_changed();
-    accounts.set_changed();
+    // Each of them is saved only once
+    edit_expenses(moved_expenses);
+    edit_earnings(moved_earnings);
 }
 
 void budget::accounts_module::handle(const std::vector<std::string>& args){
@@ -438,6 +452,30 @@ std::vector<std::string> budget::all_account_names(){
     return to_vector(accounts.data() | active_today | to_name);
 }
 
+budget::completion_index budget::account_names_completion(const std::map<size_t, size_t>& uses){
+    auto names = all_account_names();
+
+    // An account has several ids once archived, their uses are summed by name.
+    // The entries of a deleted account do not count.
+    std::map<std::string, size_t, std::less<>> uses_by_name;
+
+    for (const auto& [id, count] : uses) {
+        if (accounts.exists(id)) {
+            uses_by_name[get_account_name(id)] += count;
+        }
+    }
+
+    std::vector<size_t> name_uses;
+    name_uses.reserve(names.size());
+
+    for (const auto& name : names) {
+        auto it = uses_by_name.find(name);
+        name_uses.push_back(it == uses_by_name.end() ? 0 : it->second);
+    }
+
+    return completion_index(std::move(names), name_uses);
+}
+
 void budget::show_accounts(budget::writer& w){
     w << title_begin << "Accounts " << add_button("accounts") << title_end;
 
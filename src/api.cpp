@@ -8,6 +8,13 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <map>
 
 #include "cpp_utils/assert.hpp"
 
@@ -19,8 +26,97 @@
 
 namespace {
 
+// Clients are kept alive between requests, so that the connection (and the
+// TLS handshake) is reused. A client is only used by one request at a time,
+// concurrent requests take another client from the pool or create a new one.
+template <typename Cli>
+struct client_pool {
+    static constexpr size_t max_idle = 8;
+
+    std::unique_ptr<Cli> acquire(const std::string& server, uint16_t port) {
+        {
+            const std::scoped_lock l(lock);
+
+            auto& clients = idle[endpoint(server, port)];
+
+            if (!clients.empty()) {
+                auto cli = std::move(clients.back());
+                clients.pop_back();
+                return cli;
+            }
+        }
+
+        auto cli = std::make_unique<Cli>(server, int(port));
+        cli->set_keep_alive(true);
+        return cli;
+    }
+
+    void release(const std::string& server, uint16_t port, std::unique_ptr<Cli> cli) {
+        const std::scoped_lock l(lock);
+
+        if (auto& clients = idle[endpoint(server, port)]; clients.size() < max_idle) {
+            clients.push_back(std::move(cli));
+        }
+    }
+
+private:
+    static std::string endpoint(const std::string& server, uint16_t port) {
+        return std::format("{}:{}", server, port);
+    }
+
+    std::mutex lock;
+    std::map<std::string, std::vector<std::unique_ptr<Cli>>, std::less<>> idle;
+};
+
+client_pool<httplib::Client> clients;
+client_pool<httplib::SSLClient> ssl_clients;
+
+template <typename Cli, typename Functor>
+budget::api_response with_client(client_pool<Cli>& pool, Functor functor) {
+    auto server      = budget::config_value("server_url");
+    auto server_port = budget::get_server_port();
+
+    auto cli = pool.acquire(server, server_port);
+    auto res = functor(*cli);
+    pool.release(server, server_port, std::move(cli));
+
+    return res;
+}
+
+// Split the chunks of a response into lines, as they arrive
+struct line_splitter {
+    const budget::api_line_receiver& receiver;
+    std::string line;
+
+    void feed(const char* data, size_t length) {
+        std::string_view chunk(data, length);
+
+        while (!chunk.empty()) {
+            auto end = chunk.find('\n');
+
+            if (end == std::string_view::npos) {
+                line += chunk;
+                return;
+            }
+
+            line += chunk.substr(0, end);
+            receiver(line);
+            line.clear();
+
+            chunk.remove_prefix(end + 1);
+        }
+    }
+
+    void finish() {
+        if (!line.empty()) {
+            receiver(line);
+            line.clear();
+        }
+    }
+};
+
 template<typename Cli>
-budget::api_response base_api_get(Cli& cli, const std::string& api) {
+budget::api_response base_api_get(Cli& cli, const std::string& api, const budget::api_line_receiver& receiver = {}) {
     auto server      = budget::config_value("server_url");
     auto server_port = budget::get_server_port();
 
@@ -33,6 +129,14 @@ budget::api_response base_api_get(Cli& cli, const std::string& api) {
     req.set_header("Accept", "*/*");
     req.set_header("User-Agent", "cpp-httplib/0.1");
 
+    // The lists are plain text and shrink a lot once compressed, the client
+    // decompresses them transparently
+    if (budget::is_server_compression()) {
+        req.set_header("Accept-Encoding", "gzip, deflate");
+    } else {
+        req.set_header("Accept-Encoding", "identity");
+    }
+
     if (budget::is_secure()) {
         auto user = budget::get_web_user();
         auto password = budget::get_web_password();
@@ -41,6 +145,38 @@ budget::api_response base_api_get(Cli& cli, const std::string& api) {
         req.set_header("Authorization", authorization.c_str());
     }
 
+    // When the lines are received as they arrive, the body is never stored
+    // as a whole, except for the error message of a failed request
+    std::optional<line_splitter> splitter;
+    std::exception_ptr receiver_error;
+    std::string error_body;
+    int status = 0;
+
+    if (receiver) {
+        splitter.emplace(line_splitter{receiver, {}});
+
+        req.response_handler = [&status](const httplib::Response& response) {
+            status = response.status;
+            return true;
+        };
+
+        req.content_receiver = [&](const char* data, size_t length, uint64_t, uint64_t) {
+            if (status != 200) {
+                error_body.append(data, length);
+                return true;
+            }
+
+            try {
+                splitter->feed(data, length);
+            } catch (...) {
+                receiver_error = std::current_exception();
+                return false;
+            }
+
+            return true;
+        };
+    }
+
     auto base_res = std::make_shared<httplib::Response>();
 
     std::shared_ptr<httplib::Response> res;
@@ -51,25 +187,40 @@ budget::api_response base_api_get(Cli& cli, const std::string& api) {
         res = nullptr;
     }
 
+    // An invalid line cancels the request, the error is reported to the caller
+    if (receiver_error) {
+        std::rethrow_exception(receiver_error);
+    }
+
     if (!res) {
         LOG_F(ERROR, "Request from the API failed: No response from server");
         LOG_F(ERROR, "API: {}:{}/{}", server, server_port, api_complete);
 
         return {false, ""};
     }
+
+    if (receiver) {
+        res->body = std::move(error_body);
+    }
+
     if (res->status != 200) {
         LOG_F(ERROR, "Request from the API failed");
         LOG_F(ERROR, "API: {}:{}/{}", server, server_port, api_complete);
         LOG_F(ERROR, "Status: {}", res->status);
         LOG_F(ERROR, "Content: {}", res->body);
 
-        return {false, ""};
+        return {false, "", res->status};
+    }
+
+    if (splitter) {
+        splitter->finish();
     }
-    return {true, res->body};
+
+    return {true, res->body, res->status};
 }
 
 template<typename Cli>
-budget::api_response base_api_post(Cli& cli, const std::string& api, const std::map<std::string, std::string, std::less<>>& params) {
+budget::api_response base_api_post(Cli& cli, const std::string& api, const std::map<std::string, std::string, std::less<>>& params, bool compress = false) {
     auto server      = budget::config_value("server_url");
     auto server_port = budget::get_server_port();
 
@@ -108,6 +259,9 @@ budget::api_response base_api_post(Cli& cli, const std::string& api, const std::
     req.set_header("Content-Type", "application/x-www-form-urlencoded");
     req.body = query;
 
+    // The client is reused by other requests, the setting must always be set
+    cli.set_compress(compress);
+
     auto base_res = std::make_shared<httplib::Response>();
 
     std::shared_ptr<httplib::Response> res;
@@ -131,10 +285,10 @@ budget::api_response base_api_post(Cli& cli, const std::string& api, const std::
         LOG_F(ERROR, "Status: {}", res->status);
         LOG_F(ERROR, "Content: {}", res->body);
 
-        return {false, ""};
+        return {false, "", res->status};
     }
 
-    return {true, res->body};
+    return {true, res->body, res->status};
 }
 
 } // end of anonymous namespace
@@ -142,29 +296,66 @@ budget::api_response base_api_post(Cli& cli, const std::string& api, const std::
 budget::api_response budget::api_get(const std::string& api) {
     cpp_assert(is_server_mode(), "api_get() should only be called in server mode");
 
-    auto server      = config_value("server_url");
-    auto server_port = budget::get_server_port();
+    if (is_server_ssl()) {
+        return with_client(ssl_clients, [&api](auto& cli) { return base_api_get(cli, api); });
+    }
+
+    return with_client(clients, [&api](auto& cli) { return base_api_get(cli, api); });
+}
+
+budget::api_response budget::api_get_lines(const std::string& api, const api_line_receiver& receiver) {
+    cpp_assert(is_server_mode(), "api_get_lines() should only be called in server mode");
 
     if (is_server_ssl()) {
-        httplib::SSLClient cli(server.c_str(), int(server_port));
-        return base_api_get(cli, api);
+        return with_client(ssl_clients, [&api, &receiver](auto& cli) { return base_api_get(cli, api, receiver); });
     }
 
-    httplib::Client cli(server.c_str(), int(server_port));
-    return base_api_get(cli, api);
+    return with_client(clients, [&api, &receiver](auto& cli) { return base_api_get(cli, api, receiver); });
 }
 
 budget::api_response budget::api_post(const std::string& api, const std::map<std::string, std::string, std::less<>>& params) {
     cpp_assert(is_server_mode(), "api_post() should only be called in server mode");
 
-    auto server      = config_value("server_url");
-    auto server_port = budget::get_server_port();
+    if (is_server_ssl()) {
+        return with_client(ssl_clients, [&api, &params](auto& cli) { return base_api_post(cli, api, params); });
+    }
+
+    return with_client(clients, [&api, &params](auto& cli) { return base_api_post(cli, api, params); });
+}
+
+budget::api_response budget::api_post_compressed(const std::string& api, const std::map<std::string, std::string, std::less<>>& params) {
+    cpp_assert(is_server_mode(), "api_post_compressed() should only be called in server mode");
+
+    if (!is_server_compression()) {
+        return api_post(api, params);
+    }
+
+    api_response res;
 
     if (is_server_ssl()) {
-        httplib::SSLClient cli(server.c_str(), int(server_port));
-        return base_api_post(cli, api, params);
+        res = with_client(ssl_clients, [&api, &params](auto& cli) { return base_api_post(cli, api, params, true); });
+    } else {
+        res = with_client(clients, [&api, &params](auto& cli) { return base_api_post(cli, api, params, true); });
+    }
+
+    // Servers without compression support answer 415 Unsupported Media Type
+    if (res.status == 415) {
+        return api_post(api, params);
+    }
+
+    return res;
+}
+
+budget::api_response budget::api_post_many(const std::string& api, const std::vector<api_params>& entries) {
+    api_params params;
+
+    params["input_count"] = budget::to_string(entries.size());
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        for (const auto& [key, value] : entries[i]) {
+            params[std::format("entry{}_{}", i, key)] = value;
+        }
     }
 
-    httplib::Client cli(server.c_str(), int(server_port));
-    return base_api_post(cli, api, params);
+    return api_post_compressed(api, params);
 }
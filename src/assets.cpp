@@ -1222,7 +1222,7 @@ budget::money budget::get_asset_value_conv(const budget::asset& asset, const bud
     auto amount = get_asset_value(asset, d, cache);
 
     if (amount) {
-        return amount * exchange_rate(asset.currency, d);
+        return amount * exchange_rate(cache.currency(asset.currency), cache.default_currency(), d);
     }
     return amount;
 }
@@ -1236,7 +1236,7 @@ budget::money budget::get_asset_value_conv(const budget::asset& asset, const bud
     auto amount = get_asset_value(asset, d, cache);
 
     if (amount) {
-        return amount * exchange_rate(asset.currency, currency, d);
+        return amount * exchange_rate(cache.currency(asset.currency), cache.currency(currency), d);
     }
     return amount;
 }
@@ -0,0 +1,135 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "autosave.hpp"
+#include "config.hpp"
+#include "utils.hpp"
+
+namespace {
+
+struct autosave_state {
+    std::mutex lock;
+    std::condition_variable cv;
+    std::map<const void*, std::function<void()>> scheduled;
+    std::jthread saver;
+    bool stopping = false;
+
+    // Held while saves are running, so that an owner can wait for its save
+    std::mutex saving_lock;
+};
+
+// Never destroyed, since the modules can still use it during static
+// destruction
+autosave_state& state() {
+    static auto* instance = new autosave_state;
+    return *instance;
+}
+
+void run_saves(std::unique_lock<std::mutex>& l) {
+    auto& s = state();
+
+    auto pending = std::move(s.scheduled);
+    s.scheduled.clear();
+
+    const std::scoped_lock saving(s.saving_lock);
+
+    l.unlock();
+
+    for (auto& [owner, save] : pending) {
+        save();
+    }
+
+    l.lock();
+}
+
+void saver_job() {
+    const std::chrono::milliseconds delay(budget::to_number<int64_t>(budget::user_config_value("autosave_delay", "1000")));
+
+    auto& s = state();
+
+    std::unique_lock l(s.lock);
+
+    while (true) {
+        s.cv.wait(l, [&s]() { return s.stopping || !s.scheduled.empty(); });
+
+        // Let the next changes coalesce with the first one
+        s.cv.wait_for(l, delay, [&s]() { return s.stopping; });
+
+        run_saves(l);
+
+        if (s.stopping && s.scheduled.empty()) {
+            return;
+        }
+    }
+}
+
+} // end of anonymous namespace
+
+bool budget::schedule_save(const void* owner, std::function<void()> save) {
+    auto& s = state();
+
+    const std::scoped_lock l(s.lock);
+
+    if (s.stopping) {
+        return false;
+    }
+
+    if (!s.saver.joinable()) {
+        s.saver = std::jthread(saver_job);
+
+        // The modules are destroyed after this runs at exit
+        std::atexit(stop_autosave);
+    }
+
+    s.scheduled[owner] = std::move(save);
+
+    s.cv.notify_one();
+
+    return true;
+}
+
+void budget::cancel_save(const void* owner) {
+    auto& s = state();
+
+    {
+        const std::scoped_lock l(s.lock);
+        s.scheduled.erase(owner);
+    }
+
+    const std::scoped_lock saving(s.saving_lock);
+}
+
+void budget::flush_saves() {
+    std::unique_lock l(state().lock);
+
+    run_saves(l);
+}
+
+void budget::stop_autosave() {
+    auto& s = state();
+
+    {
+        const std::scoped_lock l(s.lock);
+        s.stopping = true;
+    }
+
+    s.cv.notify_one();
+
+    if (s.saver.joinable()) {
+        s.saver.join();
+    }
+
+    // Saves scheduled before the stop but after the last run
+    flush_saves();
+}
@@ -260,6 +260,7 @@ int main(int argc, char* argv[]) {
     }
 
     // Save the caches
+    stop_currency_cache_refresh();
     save_currency_cache();
     save_share_price_cache();
 
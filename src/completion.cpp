@@ -0,0 +1,77 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+
+#include "completion.hpp"
+#include "utils.hpp"
+
+namespace {
+
+std::vector<size_t> sorted_ranks(const std::vector<std::string>& keys) {
+    std::vector<size_t> ranks(keys.size());
+    std::iota(ranks.begin(), ranks.end(), 0);
+
+    std::ranges::stable_sort(ranks, {}, [&keys](size_t rank) -> const std::string& { return keys[rank]; });
+
+    return ranks;
+}
+
+} // end of anonymous namespace
+
+budget::completion_index::completion_index(std::vector<std::string> choices, const std::vector<size_t>& uses) {
+    std::vector<size_t> order(choices.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    if (!uses.empty()) {
+        std::ranges::stable_sort(order, std::greater<>{}, [&uses](size_t i) { return i < uses.size() ? uses[i] : 0; });
+    }
+
+    choices_.reserve(choices.size());
+    lower_.reserve(choices.size());
+
+    for (auto i : order) {
+        choices_.push_back(std::move(choices[i]));
+        lower_.push_back(to_lower(choices_.back()));
+    }
+
+    sorted_  = sorted_ranks(choices_);
+    isorted_ = sorted_ranks(lower_);
+}
+
+std::vector<std::string_view> budget::completion_index::collect(const std::vector<size_t>& sorted, const std::vector<std::string>& keys, std::string_view prefix) const {
+    auto key = [&keys](size_t rank) -> std::string_view { return keys[rank]; };
+
+    auto first = std::ranges::lower_bound(sorted, prefix, {}, key);
+    auto last  = first;
+
+    while (last != sorted.end() && keys[*last].starts_with(prefix)) {
+        ++last;
+    }
+
+    std::vector<size_t> ranks(first, last);
+    std::ranges::sort(ranks);
+
+    std::vector<std::string_view> results;
+    results.reserve(ranks.size());
+
+    for (auto rank : ranks) {
+        results.emplace_back(choices_[rank]);
+    }
+
+    return results;
+}
+
+std::vector<std::string_view> budget::completion_index::complete(std::string_view prefix) const {
+    return collect(sorted_, choices_, prefix);
+}
+
+std::vector<std::string_view> budget::completion_index::complete_icase(std::string_view prefix) const {
+    return collect(isorted_, lower_, to_lower(prefix));
+}
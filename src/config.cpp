@@ -5,6 +5,7 @@
 //  http://opensource.org/licenses/MIT)
 //=======================================================================
 
+#include <atomic>
 #include <filesystem>
 #include <iostream>
 #include <fstream>
@@ -120,10 +121,20 @@ config_type configuration;
 config_type internal;
 config_type internal_bak;
 
+// Incremented on each load or change of the configuration
+std::atomic<size_t> generation = 1;
+
 } //end of anonymous namespace
 
 bool budget::load_config() {
-    if(!load_configuration(config_file(), configuration)){
+    // A reload must not keep the values of the previous configuration file
+    configuration.clear();
+
+    const bool loaded = load_configuration(config_file(), configuration);
+
+    ++generation;
+
+    if(!loaded){
         return false;
     }
 
@@ -135,6 +146,8 @@ bool budget::load_config() {
         return false;
     }
 
+    ++generation;
+
     internal_bak = internal;
 
     //At the first start, the version is not set
@@ -145,6 +158,16 @@ bool budget::load_config() {
     return true;
 }
 
+void budget::reload_config() {
+    configuration.clear();
+    load_configuration(config_file(), configuration);
+    ++generation;
+}
+
+size_t budget::config_generation() {
+    return generation;
+}
+
 void budget::save_config() {
     if (internal != internal_bak) {
         const server_lock_guard l(internal_config_lock);
@@ -283,6 +306,7 @@ std::string budget::internal_config_value(std::string_view key){
 void budget::internal_config_set(std::string_view key, std::string_view value){
     const server_lock_guard l(internal_config_lock);
     internal.insert_or_assign(std::string(key), value);
+    ++generation;
 }
 
 void budget::internal_config_remove(std::string_view key){
@@ -290,6 +314,7 @@ void budget::internal_config_remove(std::string_view key){
     auto              it = internal.find(key);
     if (it != internal.end()) {
         internal.erase(it);
+        ++generation;
     }
 }
 
@@ -326,6 +351,10 @@ bool budget::is_server_ssl(){
     return config_contains_and_true("server_ssl");
 }
 
+bool budget::is_server_compression(){
+    return user_config_value_bool("server_compression", true);
+}
+
 bool budget::is_fortune_disabled(){
     return user_config_value_bool("disable_fortune", false);
 }
@@ -146,6 +146,10 @@ char getch() {
 } // end of anonymous namespace
 
 std::string budget::get_string_complete(const std::vector<std::string>& choices) {
+    return get_string_complete(completion_index(choices));
+}
+
+std::string budget::get_string_complete(const completion_index& choices) {
     std::string answer;
 
     if (choices.empty()) {
@@ -153,6 +157,15 @@ std::string budget::get_string_complete(const std::vector<std::string>& choices)
         return answer;
     }
 
+    auto replace_answer = [&answer](std::string_view value) {
+        for (size_t i = 0; i < answer.size(); ++i) {
+            std::cout << "\b \b";
+        }
+
+        answer = value;
+        std::cout << answer;
+    };
+
     size_t index = 0;
 
     while (true) {
@@ -173,56 +186,45 @@ std::string budget::get_string_complete(const std::vector<std::string>& choices)
                 continue;
             }
 
-            size_t      count = 0;
-            std::string valid;
+            auto matches = choices.complete(answer);
+            std::erase_if(matches, [&answer](std::string_view match) { return match.size() == answer.size(); });
+
+            // Without any choice in the same case, try again ignoring case
+            if (matches.empty()) {
+                matches = choices.complete_icase(answer);
+                std::erase_if(matches, [&answer](std::string_view match) { return match == answer; });
 
-            for (const auto& choice : choices) {
-                if (choice.size() > answer.size() && choice.starts_with(answer)) {
-                    ++count;
-                    valid = choice;
+                if (matches.size() == 1) {
+                    replace_answer(matches.front());
                 }
+
+                continue;
             }
 
-            if (count == 1) {
-                std::cout << valid.substr(answer.size(), valid.size());
-                answer = valid;
+            // Complete as much as all the choices have in common
+            std::string_view common = matches.front();
+
+            for (auto match : matches) {
+                auto mismatch = std::ranges::mismatch(common, match);
+                common        = common.substr(0, mismatch.in1 - common.begin());
             }
+
+            std::cout << common.substr(answer.size());
+            answer = common;
         } else if (c == '\033') {
             getch();
 
             const char cc = getch();
 
+            // The choices are cycled through from the most used one
             if (cc == 'A') {
-                for (size_t i = 0; i < answer.size(); ++i) {
-                    std::cout << "\b \b";
-                }
-
                 index = (index + 1) % (choices.size() + 1);
 
-                if (index > 0) {
-                    answer = choices[index - 1];
-                } else if (index == 0) {
-                    answer = "";
-                }
-
-                std::cout << answer;
+                replace_answer(index > 0 ? choices[index - 1] : "");
             } else if (cc == 'B') {
-                for (size_t i = 0; i < answer.size(); ++i) {
-                    std::cout << "\b \b";
-                }
-
-                if (index == 1) {
-                    index  = 0;
-                    answer = "";
-                } else if (index == 0) {
-                    index  = choices.size();
-                    answer = choices[index - 1];
-                } else {
-                    --index;
-                    answer = choices[index - 1];
-                }
+                index = index == 0 ? choices.size() : index - 1;
 
-                std::cout << answer;
+                replace_answer(index > 0 ? choices[index - 1] : "");
             }
         } else {
             std::cout << c;
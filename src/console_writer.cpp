@@ -194,37 +194,52 @@ void budget::console_writer::display_table(std::vector<std::string>& columns, st
         }
     }
 
+    // The visible size of each cell is computed only once
+    std::vector<size_t> sizes;
+    std::vector<size_t> offsets;
+    offsets.reserve(contents.size());
+
     for (auto& row : contents) {
+        offsets.push_back(sizes.size());
+
         for (auto& cell : row) {
             cpp::trim(cell);
+            sizes.push_back(rsize(cell));
         }
     }
 
+    std::vector<size_t> column_sizes;
+    for (auto& column : columns) {
+        column_sizes.push_back(rsize(column));
+    }
+
     std::vector<size_t> widths;
     std::vector<size_t> header_widths;
 
     if (contents.empty()) {
-        for (auto& column : columns) {
-            widths.push_back(rsize(column));
-        }
+        widths = column_sizes;
     } else {
-        auto& first = contents[0];
+        widths.assign(contents[0].size(), 0);
 
-        widths.assign(first.size(), 0);
-
-        for (auto& row : contents) {
-            for (size_t i = 0; i < row.size(); ++i) {
-                widths[i] = std::max(widths[i], rsize(row[i]) + 1);
+        for (size_t r = 0; r < contents.size(); ++r) {
+            for (size_t i = 0; i < contents[r].size(); ++i) {
+                widths[i] = std::max(widths[i], sizes[offsets[r] + i] + 1);
             }
         }
     }
 
     cpp_assert(columns.empty() || widths.size() == groups * columns.size(), "Widths incorrectly computed");
 
+    const auto underline_begin = format_code(4, 0, 7);
+    const auto underline_end   = format_code(0, 0, 7);
+
+    // The whole table is written at once
+    std::string out;
+
     // Display the header
 
     if (left) {
-        os << std::string(left, ' ');
+        out.append(left, ' ');
     }
 
     if (columns.empty()) {
@@ -239,36 +254,41 @@ void budget::console_writer::display_table(std::vector<std::string>& columns, st
         }
     } else {
         for (size_t i = 0; i < columns.size(); ++i) {
-            auto& column = columns[i];
+            const size_t column_size = column_sizes[i];
 
             size_t width = 0;
             for (size_t j = i * groups; j < (i + 1) * groups; ++j) {
                 width += widths[j];
             }
 
-            width = std::max(width, rsize(column));
-            header_widths.push_back(width + (i < columns.size() - 1 && rsize(column) >= width ? 1 : 0));
+            width = std::max(width, column_size);
+            header_widths.push_back(width + (i < columns.size() - 1 && column_size >= width ? 1 : 0));
 
             //The last space is not underlined
             --width;
 
-            os << format_code(4, 0, 7) << column << (width > rsize(column) ? std::string(width - rsize(column), ' ') : "") << format_code(0, 0, 7);
+            out += underline_begin;
+            out += columns[i];
+            if (width > column_size) {
+                out.append(width - column_size, ' ');
+            }
+            out += underline_end;
 
             //The very last column has no trailing space
 
             if (i < columns.size() - 1) {
-                os << " ";
+                out += ' ';
             }
         }
     }
 
-    os << std::endl;
+    out += '\n';
 
     // Display the contents
 
     for (size_t i = 0; i < contents.size(); ++i) {
         if (left) {
-            os << std::string(left, ' ');
+            out.append(left, ' ');
         }
 
         auto& row = contents[i];
@@ -284,19 +304,22 @@ void budget::console_writer::display_table(std::vector<std::string>& columns, st
 
                 std::string const value = format(row[column]);
 
+                // Only the special cells are changed by the formatting
+                const size_t value_size = row[column].starts_with("::") ? rsize(value) : sizes[offsets[i] + column];
+
                 acc_width += widths[column];
 
                 if (underline) {
-                    os << format_code(4, 0, 7);
-                    os << underline_format(row[column]);
-                    os << std::string(widths[column] - rsize(value) - 1, ' ');
-                    os << format_code(0, 0, 7);
+                    out += underline_begin;
+                    out += underline_format(row[column]);
+                    out.append(widths[column] - value_size - 1, ' ');
+                    out += underline_end;
                 } else {
-                    os << value;
-                    os << std::string(widths[column] - rsize(value) - 1, ' ');
+                    out += value;
+                    out.append(widths[column] - value_size - 1, ' ');
                 }
 
-                os << ' ';
+                out += ' ';
             }
 
             //The last column of the group
@@ -313,40 +336,42 @@ void budget::console_writer::display_table(std::vector<std::string>& columns, st
                 --width;
             }
 
-            auto value = format(row[last_column]);
+            auto missing = width - sizes[offsets[i] + last_column];
 
-            auto missing = width - rsize(row[last_column]);
+            if (underline) {
+                out += underline_begin;
+                out += underline_format(row[last_column]);
+            } else {
+                out += format(row[last_column]);
+            }
 
-            std::string fill_string;
             if (missing > 1) {
-                fill_string = std::string(missing - 1, ' ');
+                out.append(missing - 1, ' ');
             }
 
             if (underline) {
-                os << format_code(4, 0, 7);
-                os << underline_format(row[last_column]);
-                os << fill_string;
-                os << format_code(0, 0, 7);
-            } else {
-                os << value;
-                os << fill_string;
+                out += underline_end;
             }
 
             if (missing > 0) {
                 if (j == row.size() - 1 && underline) {
-                    os << format_code(4, 0, 7);
-                    os << ' ';
-                    os << format_code(0, 0, 7);
+                    out += underline_begin;
+                    out += ' ';
+                    out += underline_end;
                 } else {
-                    os << ' ';
+                    out += ' ';
                 }
             }
         }
 
-        os << format_code(0, 0, 7) << std::endl;
+        out += underline_end;
+        out += '\n';
     }
 
-    os << std::endl;
+    out += '\n';
+
+    os << out;
+    os.flush();
 }
 
 bool budget::console_writer::is_web() {
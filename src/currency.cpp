@@ -8,29 +8,42 @@
 #include <tuple>
 #include <utility>
 #include <iostream>
-#include <unordered_map>
+#include <fstream>
+#include <chrono>
 #include <format>
+#include <vector>
+#include <algorithm>
+#include <set>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <stop_token>
+
+#include "cpp_utils/hash.hpp"
 
 #include "currency.hpp"
 #include "assets.hpp" // For get_default_currency
+#include "data_cache.hpp"
 #include "http.hpp"
 #include "date.hpp"
 #include "config.hpp"
 #include "logging.hpp"
+#include "negative_cache.hpp"
 #include "server_lock.hpp"
+#include "single_flight.hpp"
 
 namespace {
 
-struct currency_cache_key {
-    budget::date date;
-    std::string from;
-    std::string to;
+using budget::currency_id;
 
-    currency_cache_key(const budget::date& date, std::string_view from, std::string_view to)
-        : date(date), from(from), to(to) {}
+// All the rates are stored against a single pivot currency, which always has
+// the id 0. Cross rates are derived from the two legs at lookup time
+constexpr const currency_id pivot_id = 0;
 
-    friend bool operator==(const currency_cache_key & lhs, const currency_cache_key & rhs) = default;
-};
+// The rates are fetched by windows of this many days, aligned on the epoch
+constexpr const int32_t rates_window_days = 90;
 
 // We use a struct so that we can store values of 1 that can indicate either 
 // a valid value or an invalid one
@@ -38,81 +51,727 @@ struct currency_cache_key {
 struct currency_cache_value {
     double value;
     bool   valid;
+    bool   provisional = false; // Filled after the last published rate, not saved
 };
 
-} // end of anonymous namespace
+// The rates of one currency against the pivot, indexed by day
+// A value of 0 indicates that the rate is not in cache, since it's not a
+// possible exchange rate
+struct rate_series {
+    int32_t first_day = 0;
+    std::vector<currency_cache_value> values;
+
+    const currency_cache_value* find(int32_t day) const {
+        if (day < first_day || day >= first_day + static_cast<int32_t>(values.size())) {
+            return nullptr;
+        }
+
+        const auto& value = values[day - first_day];
+        return value.value == 0.0 ? nullptr : &value;
+    }
+
+    void set(int32_t day, currency_cache_value value) {
+        if (values.empty()) {
+            first_day = day;
+        } else if (day < first_day) {
+            values.insert(values.begin(), first_day - day, currency_cache_value{0.0, false});
+            first_day = day;
+        }
+
+        if (day - first_day >= static_cast<int32_t>(values.size())) {
+            values.resize(day - first_day + 1, currency_cache_value{0.0, false});
+        }
 
-namespace std {
+        values[day - first_day] = value;
+    }
 
-template <>
-struct hash<currency_cache_key> {
-    std::size_t operator()(const currency_cache_key & key) const noexcept {
-        auto seed = std::hash<budget::date>()(key.date);
-        seed ^= std::hash<std::string>()(key.from) + 0x9e3779b9 + (seed<<6) + (seed>>2);
-        seed ^= std::hash<std::string>()(key.to) + 0x9e3779b9 + (seed<<6) + (seed>>2);
-        return seed;
+    size_t entries() const {
+        return std::ranges::count_if(values, [](const auto& value) { return value.value != 0.0; });
     }
 };
 
-} // end of namespace std
+// One rate from the provider, as the number of currency for one pivot
+struct rate_quote {
+    int32_t     day;
+    std::string currency;
+    double      value;
+};
 
-namespace {
+// The result of one call to the provider, with the window and the currencies
+// it asked for
+struct rates_fetch {
+    int32_t start_day = 0;
+    int32_t end_day   = 0;
+    std::vector<currency_id> currencies;
+    std::vector<rate_quote>  quotes;
+};
 
-// OPTIM: If necessary, this could be made faster with a two layer cache
-// We can take advantages from the low number of currency pair in the first layer
-// and then the quick hash from the high number of dates
+std::vector<std::string> currencies;
+cpp::string_hash_map<currency_id> currency_ids;
 
-std::unordered_map<currency_cache_key, currency_cache_value> exchanges;
+// The rate of the pivot to each currency, indexed by currency id
+std::vector<rate_series> rates;
 budget::server_lock exchanges_lock;
 
+// The windows of the currencies for which no rates were found recently
+budget::negative_cache currency_negatives{"currency.negative"};
+budget::cache_counters currency_counters;
+
+// The valid rates added since the cache was last saved, to be appended
+std::vector<std::pair<currency_id, int32_t>> pending_rates;
+
+// Indicates that currency.cache cannot simply be appended to and must be
+// rewritten entirely on the next save
+bool rewrite_cache = false;
+
+// Indicates that currency.cache.bin cannot simply be appended to and must be
+// rewritten entirely on the next save
+bool rewrite_binary_cache = true;
+
+// The number of currencies already written to currency.cache.bin
+size_t saved_currencies = 0;
+
+// The background refresh of the cache
+std::mutex refresh_lock;
+std::jthread refresh_thread;
+std::atomic<bool> refresh_running = false;
+std::chrono::steady_clock::time_point last_refresh;
+
+// API calls in flight, by window. Concurrent misses in the same window share
+// the same call. The result is the currencies the call asked for
+budget::single_flight<int32_t, std::vector<currency_id>> rates_fetches;
+
+constexpr const char binary_cache_magic[4] = {'B', 'W', 'C', 'C'};
+constexpr const uint32_t binary_cache_version = 3;
+
+// The records of the binary cache
+constexpr const char currency_record = 'C';
+constexpr const char series_record   = 'S';
+constexpr const char rate_record     = 'R';
+
+int32_t day_number(const budget::date& d) {
+    const std::chrono::year_month_day ymd{std::chrono::year(d._year), std::chrono::month(d._month), std::chrono::day(d._day)};
+    return std::chrono::sys_days(ymd).time_since_epoch().count();
+}
+
+budget::date from_day_number(int32_t day) {
+    const std::chrono::year_month_day ymd{std::chrono::sys_days(std::chrono::days(day))};
+
+    return {static_cast<budget::date_type>(static_cast<int>(ymd.year())),
+            static_cast<budget::date_type>(static_cast<unsigned>(ymd.month())),
+            static_cast<budget::date_type>(static_cast<unsigned>(ymd.day()))};
+}
+
+// The pivot is read once for the whole process, unlike the default currency,
+// since every stored rate is relative to it
+const std::string& pivot_currency() {
+    static const std::string currency = budget::user_config_value("currency_pivot", "EUR");
+    return currency;
+}
+
+// This function must be called with a lock!
+currency_id intern_currency(std::string_view currency) {
+    if (currencies.empty()) {
+        currencies.emplace_back(pivot_currency());
+        currency_ids[currencies.back()] = pivot_id;
+        rates.emplace_back();
+    }
+
+    if (auto it = currency_ids.find(currency); it != currency_ids.end()) {
+        return it->second;
+    }
+
+    const auto id = static_cast<currency_id>(currencies.size());
+
+    currencies.emplace_back(currency);
+    currency_ids[currencies.back()] = id;
+    rates.emplace_back();
+
+    return id;
+}
+
+// The default currency, resolved once per generation of the configuration
+currency_id default_id        = pivot_id;
+size_t      default_generation = 0;
+
+// This function must be called with a lock!
+currency_id default_currency_id() {
+    if (const auto generation = budget::config_generation(); generation != default_generation) {
+        default_id         = intern_currency(budget::get_default_currency());
+        default_generation = generation;
+    }
+
+    return default_id;
+}
+
+// This function must be called with a lock!
+const currency_cache_value* find_rate(currency_id id, int32_t day) {
+    static constexpr const currency_cache_value pivot_rate{1.0, true};
+
+    if (id == pivot_id) {
+        return &pivot_rate;
+    }
+
+    return rates[id].find(day);
+}
+
+// This function must be called with a lock!
+size_t cache_entries() {
+    size_t entries = 0;
+
+    for (const auto& series : rates) {
+        entries += series.entries();
+    }
+
+    return entries;
+}
+
+template <typename T>
+void write_binary(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_binary(std::ifstream& file, T& value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+// The binary cache is a sibling of currency.cache that can be loaded without
+// parsing each line. After its header, it's a sequence of records: the
+// interned currencies, starting with the pivot, the series of valid rates of
+// each currency and the single rates appended since the series were written
+bool load_binary_currency_cache(const std::filesystem::path& file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+
+    if (!file.is_open() || !file.good()) {
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, binary_cache_magic)) {
+        return false;
+    }
+
+    if (!read_binary(file, version) || version != binary_cache_version) {
+        return false;
+    }
+
+    std::vector<currency_id> ids;
+
+    // The file can only be appended to if its ids are the ids of the process
+    bool same_ids = true;
+
+    char record = 0;
+
+    while (file.read(&record, 1)) {
+        if (record == currency_record) {
+            uint8_t length = 0;
+            if (!read_binary(file, length)) {
+                return false;
+            }
+
+            std::string currency(length, ' ');
+            if (!file.read(currency.data(), length)) {
+                return false;
+            }
+
+            // A cache made against another pivot is useless
+            if (ids.empty() && currency != pivot_currency()) {
+                return false;
+            }
+
+            ids.push_back(intern_currency(currency));
+            same_ids = same_ids && ids.back() == ids.size() - 1;
+        } else if (record == series_record) {
+            currency_id id    = 0;
+            int32_t first_day = 0;
+            uint32_t count    = 0;
+
+            if (!read_binary(file, id) || !read_binary(file, first_day) || !read_binary(file, count) || id >= ids.size()) {
+                return false;
+            }
+
+            std::vector<double> values(count);
+            if (!file.read(reinterpret_cast<char*>(values.data()), std::streamsize(count * sizeof(double)))) {
+                return false;
+            }
+
+            auto& series = rates[ids[id]];
+
+            for (uint32_t d = 0; d < count; ++d) {
+                if (values[d] != 0.0) {
+                    series.set(first_day + static_cast<int32_t>(d), {values[d], true});
+                }
+            }
+        } else if (record == rate_record) {
+            currency_id id = 0;
+            int32_t day    = 0;
+            double value   = 0.0;
+
+            // A record cut by a crash invalidates the file
+            if (!read_binary(file, id) || !read_binary(file, day) || !read_binary(file, value) || id >= ids.size()) {
+                return false;
+            }
+
+            rates[ids[id]].set(day, {value, true});
+        } else {
+            return false;
+        }
+    }
+
+    saved_currencies     = ids.size();
+    rewrite_binary_cache = !same_ids;
+
+    return true;
+}
+
+// This function must be called with a lock!
+void save_binary_currency_cache(const std::filesystem::path& file_path) {
+    // New rates are simply appended, unless the file needs to be rewritten
+    const bool append = !rewrite_binary_cache && std::filesystem::exists(file_path);
+
+    std::ofstream file(file_path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+
+    if (!file.is_open() || !file.good()) {
+        LOG_F(INFO, "Impossible to save binary Currency Cache");
+        return;
+    }
+
+    if (!append) {
+        file.write(binary_cache_magic, sizeof(binary_cache_magic));
+        write_binary(file, binary_cache_version);
+
+        saved_currencies = 0;
+    }
+
+    // The new currencies must be written before their rates
+    for (size_t id = saved_currencies; id < currencies.size(); ++id) {
+        file.put(currency_record);
+        write_binary(file, static_cast<uint8_t>(currencies[id].size()));
+        file.write(currencies[id].data(), std::streamsize(currencies[id].size()));
+    }
+
+    saved_currencies = currencies.size();
+
+    if (append) {
+        for (const auto& [id, day] : pending_rates) {
+            if (const auto* value = rates[id].find(day); value && value->valid && !value->provisional) {
+                file.put(rate_record);
+                write_binary(file, id);
+                write_binary(file, day);
+                write_binary(file, value->value);
+            }
+        }
+    } else {
+        for (size_t id = 0; id < rates.size(); ++id) {
+            const auto& series = rates[id];
+
+            if (series.values.empty()) {
+                continue;
+            }
+
+            file.put(series_record);
+            write_binary(file, static_cast<currency_id>(id));
+            write_binary(file, series.first_day);
+            write_binary(file, static_cast<uint32_t>(series.values.size()));
+
+            // We only write down valid values
+            for (const auto& value : series.values) {
+                write_binary(file, value.valid && !value.provisional ? value.value : 0.0);
+            }
+        }
+    }
+
+    rewrite_binary_cache = false;
+}
+
+std::string_view trim_json(std::string_view value) {
+    while (!value.empty() && (std::isspace(static_cast<unsigned char>(value.front())) || value.front() == '"')) {
+        value.remove_prefix(1);
+    }
+
+    while (!value.empty() && (std::isspace(static_cast<unsigned char>(value.back())) || value.back() == '"')) {
+        value.remove_suffix(1);
+    }
+
+    return value;
+}
+
+// Parse the rates object of a timeseries response:
+// "rates": {"2020-01-02": {"USD": 1.12, "CHF": 1.08}, "2020-01-03": {...}}
+std::vector<rate_quote> parse_timeseries(const std::string& body) {
+    std::vector<rate_quote> quotes;
+
+    auto pos = body.find("\"rates\"");
+
+    if (pos == std::string::npos || (pos = body.find('{', pos)) == std::string::npos) {
+        return {};
+    }
+
+    const std::string_view view(body);
+
+    while (true) {
+        const auto day_start = body.find('"', pos + 1);
+        const auto day_end   = body.find('"', day_start + 1);
+
+        if (day_start == std::string::npos || day_end == std::string::npos) {
+            break;
+        }
+
+        const auto object_start = body.find('{', day_end);
+        const auto object_end   = body.find('}', object_start);
+
+        if (object_start == std::string::npos || object_end == std::string::npos) {
+            break;
+        }
+
+        const auto day = day_number(budget::date_from_string(view.substr(day_start + 1, day_end - day_start - 1)));
+
+        for (auto entry : budget::splitv(view.substr(object_start + 1, object_end - object_start - 1), ',')) {
+            if (auto colon = entry.find(':'); colon != std::string_view::npos) {
+                quotes.emplace_back(day, std::string(trim_json(entry.substr(0, colon))),
+                                    budget::to_number<double>(trim_json(entry.substr(colon + 1))));
+            }
+        }
+
+        // The end of the rates object
+        pos = body.find_first_not_of(" \t\r\n", object_end + 1);
+        if (pos == std::string::npos || body[pos] != ',') {
+            break;
+        }
+    }
+
+    return quotes;
+}
+
 // V2 is using api.exchangeratesapi.io
-currency_cache_value get_rate_v2(const std::string& from, const std::string& to, const std::string& date = "latest") {
+// The whole window is fetched in a single call to the timeseries endpoint
+// This function must be thread safe, it cannot touch the cache itself
+std::vector<rate_quote> get_rates_v2(int32_t start_day, int32_t end_day, const std::vector<std::string>& symbols) {
     auto access_key = budget::user_config_value("exchangeratesapi_key", "");
 
-    if (access_key.empty()) {
-        return {1.0, false};
+    if (access_key.empty() || symbols.empty()) {
+        return {};
+    }
+
+    std::string symbols_list;
+    for (const auto& symbol : symbols) {
+        if (!symbols_list.empty()) {
+            symbols_list += ',';
+        }
+
+        symbols_list += symbol;
     }
 
-    httplib::SSLClient cli("api.exchangeratesapi.io", 443);
+    httplib::Client cli(budget::user_config_value("exchangeratesapi_url", "https://api.exchangeratesapi.io"));
 
-    auto url = std::format("/{}?symbols={}&base={}&access_key={}", date, to, from, access_key);
+    auto url = std::format("/timeseries?start_date={}&end_date={}&base={}&symbols={}&access_key={}",
+                           from_day_number(start_day), from_day_number(end_day), pivot_currency(), symbols_list, access_key);
 
     auto res = cli.Get(url.c_str());
 
     if (!res) {
-        LOG_F(ERROR, "Currency(v2): No response, setting exchange between {} from {} to to 1/1", from, to);
+        LOG_F(ERROR, "Currency(v2): No response, setting exchange between {} and {} to 1/1", pivot_currency(), symbols_list);
         LOG_F(ERROR, "Currency(v2): URL is {}", url);
 
-        return {1.0, false};
+        return {};
     }
 
     if (res->status != 200) {
-        LOG_F(ERROR, "Currency(v2): Error Response {}, setting exchange between {} to {} to 1/1", res->status, from,
-              to);
+        LOG_F(ERROR, "Currency(v2): Error Response {}, setting exchange between {} and {} to 1/1", res->status,
+              pivot_currency(), symbols_list);
         LOG_F(ERROR, "Currency(v2): URL is {}", url);
         LOG_F(ERROR, "Currency(v2): Response is {}", res->body);
 
-        return {1.0, false};
+        return {};
     }
 
-    auto& buffer = res->body;
-    auto index = "\"" + to + "\":";
+    try {
+        auto quotes = parse_timeseries(res->body);
 
-    if (buffer.find(index) == std::string::npos || buffer.find('}') == std::string::npos) {
-        LOG_F(ERROR, "Currency(v2): Error parsing exchange rates, setting exchange between {} to {} to 1/1", from, to);
-        LOG_F(ERROR, "Currency(v2): URL is {}", url);
-        LOG_F(ERROR, "Currency(v2): Response is {}", res->body);
+        if (quotes.empty()) {
+            LOG_F(ERROR, "Currency(v2): Error parsing exchange rates, setting exchange between {} and {} to 1/1",
+                  pivot_currency(), symbols_list);
+            LOG_F(ERROR, "Currency(v2): URL is {}", url);
+            LOG_F(ERROR, "Currency(v2): Response is {}", res->body);
+        }
+
+        return quotes;
+    } catch (const budget::date_exception&) {
+        return {};
+    } catch (const budget::budget_exception&) {
+        return {};
+    }
+}
+
+// The window of a day, the rates are fetched by window
+int32_t rates_window(int32_t day) {
+    return day >= 0 ? day / rates_window_days : (day - rates_window_days + 1) / rates_window_days;
+}
+
+// The currencies are negative by window, a window without any rate (before
+// the history of the provider for instance) must not prevent the lookups in
+// the other windows
+// This function must be called with a lock!
+std::string negative_key(currency_id id, int32_t window) {
+    return currencies[id] + "/" + budget::date_to_string(from_day_number(window * rates_window_days));
+}
+
+// The last published rate before the given day, the provider does not publish
+// for more than a few days in a row
+// This function must be called with a lock!
+std::optional<currency_cache_value> last_rate_before(currency_id id, int32_t day) {
+    for (int32_t previous = day - 1; previous >= day - 7; --previous) {
+        if (const auto* value = rates[id].find(previous); value && value->valid) {
+            return *value;
+        }
+    }
+
+    return std::nullopt;
+}
+
+// Indicates if the first day of the window has no rate for one of the
+// currencies and there is nothing in cache to fill it from. The end of the
+// previous window must then be fetched as well, unless it failed recently
+// This function must be called with a lock!
+bool needs_previous_window(const rates_fetch& fetch, const std::vector<currency_id>& ids) {
+    const auto previous = rates_window(fetch.start_day - 1);
+
+    return std::ranges::any_of(ids, [&fetch, previous](auto id) {
+        if (id == pivot_id || last_rate_before(id, fetch.start_day) || currency_negatives.contains(negative_key(id, previous))) {
+            return false;
+        }
+
+        return std::ranges::none_of(fetch.quotes, [&fetch, id](const auto& quote) {
+            return quote.day == fetch.start_day && quote.currency == currencies[id];
+        });
+    });
+}
+
+// Store the fetched rates and fill the days the provider did not publish
+// (weekends, holidays and the days not yet published) with the last published
+// rate, from the start to the end of the window
+// This function must be called with a lock!
+void store_rates(const rates_fetch& fetch) {
+    for (const auto& quote : fetch.quotes) {
+        const auto id = intern_currency(quote.currency);
+
+        if (id == pivot_id || quote.value <= 0.0) {
+            continue;
+        }
+
+        rates[id].set(quote.day, {quote.value, true});
+        pending_rates.emplace_back(id, quote.day);
+    }
+
+    for (auto id : fetch.currencies) {
+        auto& series = rates[id];
+        auto last    = last_rate_before(id, fetch.start_day);
+
+        // In the current window, the days after the last published rate may
+        // still be published, they are provisional until fetched again
+        const bool current = fetch.end_day == day_number(budget::local_day());
+        int32_t published  = fetch.start_day - 1;
+
+        for (const auto& quote : fetch.quotes) {
+            if (quote.currency == currencies[id]) {
+                published = std::max(published, quote.day);
+            }
+        }
+
+        for (int32_t day = fetch.start_day; day <= fetch.end_day; ++day) {
+            if (const auto* value = series.find(day); value && value->valid && !value->provisional) {
+                last = *value;
+            } else if (last) {
+                const bool provisional = current && day > published;
 
-        return {1.0, false};
-    }          std::string ratio_result(buffer.begin() + buffer.find(index) + index.size(), buffer.begin() + buffer.find('}'));
+                series.set(day, {last->value, true, provisional});
 
-    return {atof(ratio_result.c_str()), true};
+                if (!provisional) {
+                    pending_rates.emplace_back(id, day);
+                }
+            }
+        }
+    }
+}
+
+// Fetch the window containing the given day, for all the known currencies,
+// and store the rates. If needed to fill the start of the window, the end of
+// the previous window is fetched as well, once.
+// Several server threads can miss in the same window at the same time. They
+// all wait on the same call, as long as it covers the currencies they need.
+// The outcome of each currency is recorded once, by the call itself
+void update_rates(int32_t day, const std::vector<currency_id>& needed, bool seed = true) {
+    const int32_t window    = rates_window(day);
+    const int32_t start_day = window * rates_window_days;
+    const int32_t end_day   = std::min(start_day + rates_window_days - 1, day_number(budget::local_day()));
+
+    while (true) {
+        auto fetched = rates_fetches.run(window, [window, start_day, end_day, seed]() {
+            rates_fetch result;
+            result.start_day = start_day;
+            result.end_day   = end_day;
+
+            std::vector<std::string> symbols;
+
+            {
+                const budget::server_lock_guard l(exchanges_lock);
+
+                for (size_t id = 0; id < currencies.size(); ++id) {
+                    if (id != pivot_id) {
+                        result.currencies.push_back(static_cast<currency_id>(id));
+                        symbols.push_back(currencies[id]);
+                    }
+                }
+            }
+
+            result.quotes = get_rates_v2(start_day, end_day, symbols);
+
+            LOG_F(INFO, "Price: Fetched {} Currency Rates ({} - {}) against {}", result.quotes.size(),
+                  budget::to_string(from_day_number(start_day)), budget::to_string(from_day_number(end_day)), pivot_currency());
+
+            bool previous = false;
+
+            if (seed) {
+                const budget::server_lock_guard l(exchanges_lock);
+                previous = needs_previous_window(result, result.currencies);
+            }
+
+            // The previous window must be stored first to fill the start of this one
+            if (previous) {
+                update_rates(start_day - 1, result.currencies, false);
+            }
+
+            const budget::server_lock_guard l(exchanges_lock);
+
+            store_rates(result);
+
+            for (auto id : result.currencies) {
+                bool found = false;
+
+                for (int32_t d = start_day; d <= end_day && !found; ++d) {
+                    const auto* value = rates[id].find(d);
+                    found = value && value->valid;
+                }
+
+                // A window fetched again for the other currencies does not
+                // extend the delay of the currencies already negative
+                if (found) {
+                    currency_negatives.success(negative_key(id, window));
+                } else if (!currency_negatives.contains(negative_key(id, window))) {
+                    currency_negatives.failure(negative_key(id, window));
+                }
+            }
+
+            return result.currencies;
+        });
+
+        if (std::ranges::all_of(needed, [&fetched](auto id) { return std::ranges::find(fetched, id) != fetched.end(); })) {
+            return;
+        }
+    }
+}
+
+// This function must be called with a lock!
+void write_rate(std::ofstream& file, currency_id id, int32_t day) {
+    if (const auto* value = rates[id].find(day); value && value->valid && !value->provisional) {
+        file << from_day_number(day) << ':' << currencies[pivot_id] << ':' << currencies[id] << ':' << value->value << std::endl;
+    }
+}
+
+// Wait for the given duration, unless a stop is requested
+void wait_or_stop(std::stop_token stop, std::chrono::milliseconds duration) {
+    std::mutex m;
+    std::condition_variable_any cv;
+    std::unique_lock l(m);
+    cv.wait_for(l, stop, duration, [] { return false; });
+}
+
+// Only the latest rates of the currencies in use are refreshed, there is no
+// point in refreshing the history or currencies not used anymore
+void refresh_job(std::stop_token stop) {
+    std::set<std::string, std::less<>> used;
+
+    {
+        budget::data_cache cache;
+
+        for (const auto& asset : cache.active_user_assets()) {
+            used.insert(asset.currency);
+        }
+
+        for (const auto& liability : cache.liabilities()) {
+            used.insert(liability.currency);
+        }
+    }
+
+    used.insert(budget::get_default_currency());
+
+    // Minimum delay between two calls to the provider
+    const std::chrono::milliseconds delay(budget::to_number<size_t>(budget::user_config_value("currency_refresh_delay", "1000")));
+
+    const auto today = day_number(budget::local_day());
+
+    for (const auto& currency : used) {
+        if (stop.stop_requested()) {
+            return;
+        }
+
+        currency_id id = pivot_id;
+
+        {
+            const budget::server_lock_guard l(exchanges_lock);
+
+            id = intern_currency(currency);
+
+            // A provisional rate is fetched again, the rate may have been
+            // published since
+            if (const auto* value = find_rate(id, today); value && !value->provisional) {
+                continue;
+            }
+        }
+
+        update_rates(today, {id});
+
+        wait_or_stop(stop, delay);
+    }
+
+    budget::save_currency_cache();
+
+    LOG_F(INFO, "Currency Cache has been refreshed");
 }
 
 } // end of anonymous namespace
 
 void budget::load_currency_cache(){
-    const auto file_path = budget::path_to_budget_file("currency.cache");
+    currency_negatives.load();
+
+    const auto file_path        = budget::path_to_budget_file("currency.cache");
+    const auto binary_file_path = budget::path_to_budget_file("currency.cache.bin");
+
+    const server_lock_guard l(exchanges_lock);
+
+    // The binary cache is only used if it's at least as recent as the text cache
+    std::error_code ec;
+    if (std::filesystem::exists(binary_file_path, ec)
+        && (!std::filesystem::exists(file_path, ec)
+            || std::filesystem::last_write_time(binary_file_path, ec) >= std::filesystem::last_write_time(file_path, ec))) {
+        if (load_binary_currency_cache(binary_file_path)) {
+            LOG_F(INFO, "Currency Cache has been loaded from {}", binary_file_path.string());
+            LOG_F(INFO, "Currency Cache has {} entries", cache_entries());
+            return;
+        }
+
+        LOG_F(INFO, "Invalid binary Currency Cache, falling back to {}", file_path.string());
+
+        currencies.clear();
+        currency_ids.clear();
+        rates.clear();
+    }
+
+    // The binary sibling is either missing, older or invalid, it must be replaced
+    rewrite_binary_cache = true;
 
     std::ifstream file(file_path);
 
@@ -129,59 +788,136 @@ void budget::load_currency_cache(){
 
         auto parts = splitv(line, ':');
 
-        const currency_cache_key key(date_from_string(parts[0]), parts[1], parts[2]);
-        exchanges[key] = {budget::to_number<double>(parts[3]), true};
+        const auto from = intern_currency(parts[1]);
+        const auto to   = intern_currency(parts[2]);
+        const auto day  = day_number(date_from_string(parts[0]));
+        const auto rate = budget::to_number<double>(parts[3]);
+
+        // Older caches contain direct pairs, only the ones against the pivot
+        // can be kept, the others will be derived from them
+        if (from == pivot_id && to != pivot_id) {
+            rates[to].set(day, {rate, true});
+        } else if (to == pivot_id && from != pivot_id) {
+            rates[from].set(day, {1.0 / rate, true});
+            rewrite_cache = true;
+        } else {
+            rewrite_cache = true;
+        }
     }
 
-    LOG_F(INFO, "Share Price Cache has been loaded from {}", file_path.string());
-    LOG_F(INFO, "Share Price Cache has {} entries", exchanges.size());
+    LOG_F(INFO, "Currency Cache has been loaded from {}", file_path.string());
+    LOG_F(INFO, "Currency Cache has {} entries", cache_entries());
 }
 
 void budget::save_currency_cache() {
+    currency_negatives.save();
+
+    const auto stats = currency_counters.stats();
+    LOG_F(INFO, "Currency Cache: {} hits, {} misses, {} negative hits", stats.hits, stats.misses, stats.negative_hits);
+
     const auto file_path = budget::path_to_budget_file("currency.cache");
 
-    std::ofstream file(file_path);
+    const server_lock_guard l(exchanges_lock);
+
+    // Nothing new since the last save
+    if (!rewrite_cache && !rewrite_binary_cache && pending_rates.empty() && std::filesystem::exists(file_path)) {
+        return;
+    }
+
+    // New rates are simply appended, unless the file needs to be rewritten
+    const bool append = !rewrite_cache && std::filesystem::exists(file_path);
+
+    std::ofstream file(file_path, append ? std::ios::app : std::ios::trunc);
 
     if (!file.is_open() || !file.good()){
         LOG_F(INFO, "Impossible to save Currency Cache");
         return;
     }
 
-    {
-        const server_lock_guard l(exchanges_lock);
+    if (append) {
+        for (const auto& [id, day] : pending_rates) {
+            write_rate(file, id, day);
+        }
+    } else {
+        for (size_t id = 0; id < rates.size(); ++id) {
+            const auto& series = rates[id];
 
-        for (auto & [key, value] : exchanges) {
-            // We only write down valid values
-            if (value.valid) {
-                file << key.date << ':' << key.from << ':' << key.to << ':' << value.value << std::endl;
+            for (size_t d = 0; d < series.values.size(); ++d) {
+                write_rate(file, static_cast<currency_id>(id), series.first_day + static_cast<int32_t>(d));
             }
         }
     }
 
-    LOG_F(INFO, "Share Price Cache has been loaded to {}", file_path.string());
-    LOG_F(INFO, "Share Price Cache has {} entries", exchanges.size());
+    file.close();
+
+    // The binary sibling must be written after the text file to be considered
+    // It's rewritten as well when the text file is
+    rewrite_binary_cache = rewrite_binary_cache || !append;
+    save_binary_currency_cache(budget::path_to_budget_file("currency.cache.bin"));
+
+    LOG_F(INFO, "Currency Cache has been {} to {} ({} new entries)", append ? "appended" : "saved", file_path.string(), pending_rates.size());
+    LOG_F(INFO, "Currency Cache has {} entries", cache_entries());
+
+    pending_rates.clear();
+    rewrite_cache = false;
+}
+
+budget::cache_stats budget::currency_cache_stats() {
+    return currency_counters.stats();
 }
 
 void budget::refresh_currency_cache(){
-    std::unordered_map<currency_cache_key, currency_cache_value> copy;
+    const std::scoped_lock l(refresh_lock);
 
-    {
-        const server_lock_guard l(exchanges_lock);
+    // The refresh is rate-limited
+    const std::chrono::minutes interval(to_number<size_t>(user_config_value("currency_refresh_interval", "60")));
 
-        copy = exchanges;
+    if (refresh_running) {
+        LOG_F(INFO, "Currency Cache is already being refreshed");
+        return;
     }
 
-    // Refresh/Prefetch the current exchange rates
-    for (const auto & [key, value] : copy) {
-        exchange_rate(key.from, key.to);
+    if (refresh_thread.joinable()) {
+        if (std::chrono::steady_clock::now() - last_refresh < interval) {
+            return;
+        }
+
+        refresh_thread.join();
     }
 
-    LOG_F(INFO, "Currency Cache has been refreshed");
-    LOG_F(INFO, "Currency Cache has {} entries", exchanges.size());
+    refresh_running = true;
+    last_refresh    = std::chrono::steady_clock::now();
+
+    refresh_thread = std::jthread([](std::stop_token stop) {
+        // The flag must be reset however the job ends
+        struct running_guard {
+            ~running_guard() {
+                refresh_running = false;
+            }
+        } guard;
+
+        // An exception must not escape the thread, it would terminate the process
+        try {
+            refresh_job(stop);
+        } catch (const std::exception& e) {
+            LOG_F(ERROR, "Currency Cache refresh failed: {}", e.what());
+        } catch (...) {
+            LOG_F(ERROR, "Currency Cache refresh failed");
+        }
+    });
+}
+
+void budget::stop_currency_cache_refresh(){
+    const std::scoped_lock l(refresh_lock);
+
+    if (refresh_thread.joinable()) {
+        refresh_thread.request_stop();
+        refresh_thread.join();
+    }
 }
 
 double budget::exchange_rate(const std::string& from){
-    return exchange_rate(from, get_default_currency());
+    return exchange_rate(from, budget::local_day());
 }
 
 double budget::exchange_rate(const std::string& from, const std::string& to){
@@ -189,7 +925,17 @@ double budget::exchange_rate(const std::string& from, const std::string& to){
 }
 
 double budget::exchange_rate(const std::string& from, const budget::date& d) {
-    return exchange_rate(from, get_default_currency(), d);
+    currency_id from_id = 0;
+    currency_id to_id   = 0;
+
+    {
+        server_lock_guard l(exchanges_lock);
+
+        from_id = intern_currency(from);
+        to_id   = default_currency_id();
+    }
+
+    return exchange_rate(from_id, to_id, d);
 }
 
 double budget::exchange_rate(const std::string& from, const std::string& to, const budget::date& d) {
@@ -198,38 +944,101 @@ double budget::exchange_rate(const std::string& from, const std::string& to, con
     if (from == to) {
         return 1.0;
     }
+
+    currency_id from_id = 0;
+    currency_id to_id   = 0;
+
+    {
+        server_lock_guard l(exchanges_lock);
+
+        from_id = intern_currency(from);
+        to_id   = intern_currency(to);
+    }
+
+    return exchange_rate(from_id, to_id, d);
+}
+
+budget::currency_id budget::resolve_currency(std::string_view currency) {
+    server_lock_guard l(exchanges_lock);
+    return intern_currency(currency);
+}
+
+budget::currency_id budget::resolve_default_currency() {
+    server_lock_guard l(exchanges_lock);
+    return default_currency_id();
+}
+
+double budget::exchange_rate(currency_id from_id, currency_id to_id, const budget::date& d) {
+    if (from_id == to_id) {
+        return 1.0;
+    }
     if (d > budget::local_day()) {
-        return exchange_rate(from, to, budget::local_day());
+        return exchange_rate(from_id, to_id, budget::local_day());
     }
-    currency_cache_key key(d, from, to);
+
+    const auto day = day_number(d);
+
+    // If any of the legs is invalid, the cross rate is invalid
+    auto cross_rate = [](const currency_cache_value& from_rate, const currency_cache_value& to_rate) {
+        if (!from_rate.valid || !to_rate.valid) {
+            return 1.0;
+        }
+
+        return to_rate.value / from_rate.value;
+    };
+
+    std::vector<currency_id> missing;
 
     // Return directly if we already have the data in cache
     {
-
         server_lock_guard l(exchanges_lock);
 
-        if (exchanges.contains(key)) {
-            return exchanges[key].value;
+        const auto* from_rate = find_rate(from_id, day);
+        const auto* to_rate   = find_rate(to_id, day);
+
+        if (from_rate && to_rate) {
+            ++currency_counters.hits;
+            return cross_rate(*from_rate, *to_rate);
+        }
+
+        // The currencies that failed recently are not fetched again
+        for (auto [id, rate] : {std::pair{from_id, from_rate}, std::pair{to_id, to_rate}}) {
+            if (rate) {
+                continue;
+            }
+
+            if (currency_negatives.contains(negative_key(id, rates_window(day)))) {
+                rates[id].set(day, {1.0, false});
+            } else {
+                missing.push_back(id);
+            }
+        }
+
+        if (missing.empty()) {
+            ++currency_counters.negative_hits;
+            return 1.0;
         }
     }
 
     // Otherwise, make the API call without the lock
 
-    auto rate = get_rate_v2(from, to, date_to_string(d));
+    ++currency_counters.misses;
 
-    LOG_F(INFO, "Price: Currency Rate ({}) from {} to {} = {} (valid: {})", budget::to_string(d), from, to,
-          budget::to_string(rate.value), rate.valid);
+    update_rates(day, missing);
 
-    // Update the cache and the reverse cache with the lock
+    server_lock_guard l(exchanges_lock);
 
-    currency_cache_key reverse_key(d, to, from);
+    // The rates that could not be found are invalid, for this process only
+    for (auto id : missing) {
+        if (!find_rate(id, day)) {
+            LOG_F(INFO, "Price: Currency Rate ({}) from {} to {} not found, using 1/1", budget::to_string(d), pivot_currency(), currencies[id]);
+            rates[id].set(day, {1.0, false});
+        }
+    }
 
-    {
-        server_lock_guard l(exchanges_lock);
+    const auto rate = cross_rate(*find_rate(from_id, day), *find_rate(to_id, day));
 
-        exchanges[key] = rate;
-        exchanges[reverse_key] = {1.0 / rate.value, rate.valid};
-    }
+    LOG_F(INFO, "Price: Currency Rate ({}) from {} to {} = {}", budget::to_string(d), currencies[from_id], currencies[to_id], budget::to_string(rate));
 
-    return rate.value;
+    return rate;
 }
@@ -7,6 +7,7 @@
 
 #include <charconv>
 #include <array>
+#include <future>
 
 #include "data.hpp"
 #include "utils.hpp"
@@ -265,3 +266,29 @@ bool budget::migrate_database(size_t old_data_version) {
 
     return true;
 }
+
+void budget::load_concurrently(std::initializer_list<void (*)()> loaders) {
+    if (!is_server_mode() || loaders.size() < 2) {
+        for (auto& loader : loaders) {
+            loader();
+        }
+
+        return;
+    }
+
+    std::vector<std::future<void>> loads;
+    loads.reserve(loaders.size());
+
+    for (auto& loader : loaders) {
+        loads.emplace_back(std::async(std::launch::async, loader));
+    }
+
+    // Wait for all of them before rethrowing the first failure, if any
+    for (auto& load : loads) {
+        load.wait();
+    }
+
+    for (auto& load : loads) {
+        load.get();
+    }
+}
@@ -5,204 +5,240 @@
 //  http://opensource.org/licenses/MIT)
 //=======================================================================
 
+#include <mutex>
+
 #include "data_cache.hpp"
 #include "views.hpp"
 
 using namespace budget;
 
 std::vector<earning> & data_cache::earnings() {
-    if (earnings_.empty()) {
+    std::call_once(earnings_flag_, [this]() {
         earnings_ = all_earnings();
-    }
+    });
 
     return earnings_;
 }
 
 std::vector<earning> & data_cache::sorted_earnings() {
-    if (sorted_earnings_.empty()) {
+    std::call_once(sorted_earnings_flag_, [this]() {
         sorted_earnings_ = all_earnings();
 
         std::ranges::sort(sorted_earnings_, [](auto& lhs, auto& rhs) {
             return lhs.date < rhs.date;
         });
-    }
+    });
 
     return sorted_earnings_;
 }
 
 std::vector<debt> & data_cache::debts() {
-    if (debts_.empty()) {
+    std::call_once(debts_flag_, [this]() {
         debts_ = all_debts();
-    }
+    });
 
     return debts_;
 }
 
 std::vector<fortune> & data_cache::fortunes() {
-    if (fortunes_.empty()) {
+    std::call_once(fortunes_flag_, [this]() {
         fortunes_ = all_fortunes();
-    }
+    });
 
     return fortunes_;
 }
 
 std::vector<asset_value> & data_cache::asset_values() {
-    if (asset_values_.empty()) {
+    std::call_once(asset_values_flag_, [this]() {
         asset_values_ = all_asset_values();
-    }
+    });
 
     return asset_values_;
 }
 
 std::vector<asset_value> & data_cache::sorted_asset_values() {
-    if (sorted_asset_values_.empty()) {
+    std::call_once(sorted_asset_values_flag_, [this]() {
         sorted_asset_values_ = all_asset_values();
 
         std::ranges::stable_sort(sorted_asset_values_, [](auto& lhs, auto& rhs) {
             return lhs.set_date < rhs.set_date;
         });
-    }
+    });
 
     return sorted_asset_values_;
 }
 
 std::unordered_map<size_t, std::vector<asset_value>> & data_cache::sorted_group_asset_values(bool liability) {
     if (liability) {
-        if (sorted_group_asset_values_liabilities_.empty()) {
+        std::call_once(sorted_group_asset_values_liabilities_flag_, [this]() {
             for (const auto& asset_value : sorted_asset_values() | liability_only) {
                 sorted_group_asset_values_liabilities_[asset_value.asset_id].push_back(asset_value);
             }
-        }
+        });
 
         return sorted_group_asset_values_liabilities_;
     }
 
-    if (sorted_group_asset_values_.empty()) {
+    std::call_once(sorted_group_asset_values_flag_, [this]() {
         for (const auto& asset_value : sorted_asset_values() | not_liability) {
             sorted_group_asset_values_[asset_value.asset_id].push_back(asset_value);
         }
-    }
+    });
 
     return sorted_group_asset_values_;
 }
 
 std::vector<liability> & data_cache::liabilities() {
-    if (liabilities_.empty()) {
+    std::call_once(liabilities_flag_, [this]() {
         liabilities_ = all_liabilities();
-    }
+    });
 
     return liabilities_;
 }
 
 std::vector<recurring> & data_cache::recurrings() {
-    if (recurrings_.empty()) {
+    std::call_once(recurrings_flag_, [this]() {
         recurrings_ = all_recurrings();
-    }
+    });
 
     return recurrings_;
 }
 
 std::vector<income> & data_cache::incomes() {
-    if (incomes_.empty()) {
+    std::call_once(incomes_flag_, [this]() {
         incomes_ = all_incomes();
-    }
+    });
 
     return incomes_;
 }
 
 std::vector<account> & data_cache::accounts() {
-    if (accounts_.empty()) {
+    std::call_once(accounts_flag_, [this]() {
         accounts_ = all_accounts();
-    }
+    });
 
     return accounts_;
 }
 
 std::vector<asset_share> & data_cache::asset_shares() {
-    if (asset_shares_.empty()) {
+    std::call_once(asset_shares_flag_, [this]() {
         asset_shares_ = all_asset_shares();
-    }
+    });
 
     return asset_shares_;
 }
 
 std::vector<asset_share> & data_cache::sorted_asset_shares() {
-    if (sorted_asset_shares_.empty()) {
+    std::call_once(sorted_asset_shares_flag_, [this]() {
         sorted_asset_shares_ = asset_shares();
 
         std::ranges::sort(sorted_asset_shares_, [](auto& lhs, auto& rhs) {
             return lhs.date < rhs.date;
         });
-    }
+    });
 
     return sorted_asset_shares_;
 }
 
 std::vector<asset_class> & data_cache::asset_classes() {
-    if (asset_classes_.empty()) {
+    std::call_once(asset_classes_flag_, [this]() {
         asset_classes_ = all_asset_classes();
-    }
+    });
 
     return asset_classes_;
 }
 
 std::vector<objective> & data_cache::objectives() {
-    if (objectives_.empty()) {
+    std::call_once(objectives_flag_, [this]() {
         objectives_ = all_objectives();
-    }
+    });
 
     return objectives_;
 }
 
 std::vector<expense> & data_cache::expenses() {
-    if (expenses_.empty()) {
+    std::call_once(expenses_flag_, [this]() {
         expenses_ = all_expenses();
-    }
+    });
 
     return expenses_;
 }
 
 std::vector<expense> & data_cache::sorted_expenses() {
-    if (sorted_expenses_.empty()) {
+    std::call_once(sorted_expenses_flag_, [this]() {
         sorted_expenses_ = expenses();
 
         std::ranges::sort(sorted_expenses_, [](auto& lhs, auto& rhs) {
             return lhs.date < rhs.date;
         });
-    }
+    });
 
     return sorted_expenses_;
 }
 
 std::vector<asset> & data_cache::assets() {
-    if (assets_.empty()) {
+    std::call_once(assets_flag_, [this]() {
         assets_ = all_assets();
-    }
+    });
 
     return assets_;
 }
 
 const std::vector<asset> & data_cache::user_assets() {
-    if (user_assets_.empty()) {
+    std::call_once(user_assets_flag_, [this]() {
         std::ranges::copy(assets() | is_user, std::back_inserter(user_assets_));
-    }
+    });
 
     return user_assets_;
 }
 
 std::vector<asset> & data_cache::active_user_assets() {
-    if (active_user_assets_.empty()) {
+    std::call_once(active_user_assets_flag_, [this]() {
         std::ranges::copy(assets() | is_user | is_active, std::back_inserter(active_user_assets_));
-    }
+    });
 
     return active_user_assets_;
 }
 
 std::vector<wish> & data_cache::wishes() {
-    if (wishes_.empty()) {
+    std::call_once(wishes_flag_, [this]() {
         wishes_ = all_wishes();
-    }
+    });
 
     return wishes_;
 }
 
+
+void data_cache::resolve_currencies() {
+    std::call_once(currencies_flag_, [this]() {
+        for (const auto& asset : assets()) {
+            if (!currencies_.contains(asset.currency)) {
+                currencies_[asset.currency] = resolve_currency(asset.currency);
+            }
+        }
+
+        for (const auto& liability : liabilities()) {
+            if (!currencies_.contains(liability.currency)) {
+                currencies_[liability.currency] = resolve_currency(liability.currency);
+            }
+        }
+
+        default_currency_ = resolve_default_currency();
+    });
+}
+
+currency_id data_cache::currency(std::string_view code) {
+    resolve_currencies();
+
+    if (auto it = currencies_.find(code); it != currencies_.end()) {
+        return it->second;
+    }
+
+    return resolve_currency(code);
+}
+
+currency_id data_cache::default_currency() {
+    resolve_currencies();
+
+    return default_currency_;
+}
@@ -13,10 +13,12 @@
 #include "args.hpp"
 #include "accounts.hpp"
 #include "data.hpp"
+#include "listing.hpp"
 #include "guid.hpp"
 #include "config.hpp"
 #include "utils.hpp"
 #include "console.hpp"
+#include "completion.hpp"
 #include "writer.hpp"
 #include "budget_exception.hpp"
 #include "views.hpp"
@@ -27,6 +29,37 @@ namespace {
 
 data_handler<earning> earnings{"earnings", "earnings.data"};
 
+// The accounts are proposed from the one with the most earnings
+completion_index account_completion() {
+    std::map<size_t, size_t> uses;
+
+    for (const auto& earning : earnings.data()) {
+        ++uses[earning.account];
+    }
+
+    return account_names_completion(uses);
+}
+
+// The listing of all the earnings, or of a window of them. The full listing
+// displays an empty table when there are no earnings.
+template <typename R>
+void show_earnings_listing(const R& range, bool windowed, budget::writer& w) {
+    w << title_begin << "All Earnings " << add_button("earnings") << title_end;
+
+    std::vector<std::string> columns = {"ID", "Date", "Account", "Name", "Amount"};
+    std::vector<std::vector<std::string>> contents;
+
+    for(auto& earning : range){
+        contents.push_back({to_string(earning.id), to_string(earning.date), get_account(earning.account).name, earning.name, to_string(earning.amount)});
+    }
+
+    if (windowed && contents.empty()) {
+        w << "No earnings" << end_of_line;
+    } else {
+        w.display_table(columns, contents);
+    }
+}
+
 } //end of anonymous namespace
 
 std::map<std::string, std::string, std::less<>> budget::earning::get_params() const {
@@ -43,8 +76,7 @@ std::map<std::string, std::string, std::less<>> budget::earning::get_params() co
 }
 
 void budget::earnings_module::load(){
-    load_earnings();
-    load_accounts();
+    load_concurrently({load_earnings, load_accounts});
 }
 
 void budget::earnings_module::unload(){
@@ -71,7 +103,19 @@ void budget::earnings_module::handle(const std::vector<std::string>& args){
             throw budget_exception("Too many arguments to earning show");
         }
     } else if (subcommand == "all") {
-        show_all_earnings(w);
+        std::vector<std::string> options(args.begin() + 2, args.end());
+
+        auto window = listing_window_option(options);
+
+        if (!options.empty()) {
+            throw budget_exception("Invalid arguments to earning all");
+        }
+
+        if (window.is_windowed()) {
+            show_all_earnings(window, w);
+        } else {
+            show_all_earnings(w);
+        }
     } else if (subcommand == "add") {
         earning earning;
         earning.guid = generate_guid();
@@ -80,7 +124,7 @@ void budget::earnings_module::handle(const std::vector<std::string>& args){
         edit_date(earning.date, "Date");
 
         std::string account_name;
-        edit_string_complete(account_name, "Account", all_account_names(), not_empty_checker(), account_checker(earning.date));
+        edit_string_complete(account_name, "Account", account_completion(), not_empty_checker(), account_checker(earning.date));
         earning.account = get_account(account_name, earning.date.year(), earning.date.month()).id;
 
         edit_string(earning.name, "Name", not_empty_checker());
@@ -108,7 +152,7 @@ void budget::earnings_module::handle(const std::vector<std::string>& args){
         edit_date(earning.date, "Date");
 
         auto account_name = get_account(earning.account).name;
-        edit_string_complete(account_name, "Account", all_account_names(), not_empty_checker(), account_checker(earning.date));
+        edit_string_complete(account_name, "Account", account_completion(), not_empty_checker(), account_checker(earning.date));
         earning.account = get_account(account_name, earning.date.year(), earning.date.month()).id;
 
         edit_string(earning.name, "Name", not_empty_checker());
@@ -160,6 +204,16 @@ bool budget::edit_earning(const earning& earning){
     return earnings.indirect_edit(earning);
 }
 
+void budget::edit_earnings(const std::vector<earning>& edited_earnings){
+    auto batch = earnings.begin_batch();
+
+    for (const auto& earning : edited_earnings) {
+        batch.edit(earning);
+    }
+
+    batch.commit();
+}
+
 bool budget::indirect_edit_earning(const earning & earning, bool propagate) {
     return earnings.indirect_edit(earning, propagate);
 }
@@ -172,17 +226,17 @@ size_t budget::add_earning(budget::earning&& earning){
     return earnings.add(std::move(earning));
 }
 
-void budget::show_all_earnings(budget::writer& w){
-    w << title_begin << "All Earnings " << add_button("earnings") << title_end;
-
-    std::vector<std::string> columns = {"ID", "Date", "Account", "Name", "Amount"};
-    std::vector<std::vector<std::string>> contents;
+std::vector<size_t> budget::add_earnings(std::vector<earning>&& new_earnings){
+    return earnings.add_many(std::move(new_earnings));
+}
 
-    for(auto& earning : earnings.data()){
-        contents.push_back({to_string(earning.id), to_string(earning.date), get_account(earning.account).name, earning.name, to_string(earning.amount)});
-    }
+void budget::show_all_earnings(budget::writer& w){
+    show_earnings_listing(earnings.data(), false, w);
+}
 
-    w.display_table(columns, contents);
+void budget::show_all_earnings(const listing_window& window, budget::writer& w){
+    // Only the visible earnings are copied and formatted
+    show_earnings_listing(earnings.window(window), true, w);
 }
 
 void budget::search_earnings(std::string_view search, budget::writer& w){
@@ -5,19 +5,24 @@
 //  http://opensource.org/licenses/MIT)
 //=======================================================================
 
+#include <cctype>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <mutex>
 
 #include "expenses.hpp"
 #include "args.hpp"
 #include "accounts.hpp"
 #include "data.hpp"
+#include "listing.hpp"
+#include "trigram_index.hpp"
 #include "guid.hpp"
 #include "config.hpp"
 #include "utils.hpp"
 #include "console.hpp"
+#include "completion.hpp"
 #include "views.hpp"
 #include "writer.hpp"
 #include "budget_exception.hpp"
@@ -28,6 +33,74 @@ namespace {
 
 data_handler<expense> expenses{"expenses", "expenses.data"};
 
+// The accounts are proposed from the one with the most persistent expenses
+completion_index account_completion() {
+    std::map<size_t, size_t> uses;
+
+    for (const auto& expense : expenses.data() | persistent) {
+        ++uses[expense.account];
+    }
+
+    return account_names_completion(uses);
+}
+
+// The names of the expenses are indexed for searching in the server. The
+// index is built on the first search and rebuilt after the expenses have
+// changed. A command line only searches once, which is cheaper as a scan than
+// as the building of an index.
+struct expenses_search_index {
+    bool                 built    = false;
+    size_t               revision = 0;
+    std::vector<expense> entries;
+    trigram_index        names;
+};
+
+std::mutex            search_lock;
+expenses_search_index search_index;
+
+bool contains_ignore_case(std::string_view text, std::string_view search) {
+    auto it = std::ranges::search(text, search, [](char a, char b) { return std::tolower(a) == std::tolower(b); });
+
+    return !it.empty();
+}
+
+// The expenses whose name or original name contains the search
+std::vector<expense> search_expenses_by_name(std::string_view search) {
+    std::vector<expense> found;
+
+    if (!is_server_running()) {
+        for (auto& expense : expenses.data()) {
+            if (contains_ignore_case(expense.name, search) || contains_ignore_case(expense.original_name, search)) {
+                found.push_back(std::move(expense));
+            }
+        }
+
+        return found;
+    }
+
+    const std::scoped_lock l(search_lock);
+
+    if (!search_index.built || search_index.revision != expenses.revision()) {
+        search_index          = {};
+        search_index.revision = expenses.revision();
+        search_index.entries  = expenses.data();
+
+        // Both names are indexed as one text, a search cannot contain the
+        // separator and therefore cannot match across them
+        for (const auto& expense : search_index.entries) {
+            search_index.names.add(expense.name + '\n' + expense.original_name);
+        }
+
+        search_index.built = true;
+    }
+
+    for (auto position : search_index.names.search(search)) {
+        found.push_back(search_index.entries[position]);
+    }
+
+    return found;
+}
+
 void show_templates() {
     std::vector<std::string>              columns = {"ID", "Account", "Name", "Amount"};
     std::vector<std::vector<std::string>> contents;
@@ -47,6 +120,31 @@ void show_templates() {
     }
 }
 
+// The listing of all the expenses, or of a window of them. The full listing
+// displays an empty table when there are no expenses.
+template <typename R>
+void show_expenses_listing(const R& range, bool windowed, budget::writer& w) {
+    w << title_begin << "All Expenses " << add_button("expenses") << title_end;
+
+    std::vector<std::string> columns = {"ID", "Date", "Account", "Name", "Amount", "Edit"};
+    std::vector<std::vector<std::string>> contents;
+
+    for (auto& expense : range) {
+        contents.push_back({to_string(expense.id),
+                            to_string(expense.date),
+                            get_account(expense.account).name,
+                            expense.name,
+                            to_string(expense.amount),
+                            "::edit::expenses::" + to_string(expense.id)});
+    }
+
+    if (windowed && contents.empty()) {
+        w << "No expenses" << end_of_line;
+    } else {
+        w.display_table(columns, contents);
+    }
+}
+
 } //end of anonymous namespace
 
 std::map<std::string, std::string, std::less<>> budget::expense::get_params() const {
@@ -63,8 +161,7 @@ std::map<std::string, std::string, std::less<>> budget::expense::get_params() co
 }
 
 void budget::expenses_module::load(){
-    load_expenses();
-    load_accounts();
+    load_concurrently({load_expenses, load_accounts});
 }
 
 void budget::expenses_module::unload(){
@@ -91,7 +188,19 @@ void budget::expenses_module::handle(const std::vector<std::string>& args){
             throw budget_exception("Too many arguments to expense show");
         }
     } else if (subcommand == "all") {
-        show_all_expenses(w);
+        std::vector<std::string> options(args.begin() + 2, args.end());
+
+        auto window = listing_window_option(options);
+
+        if (!options.empty()) {
+            throw budget_exception("Invalid arguments to expense all");
+        }
+
+        if (window.is_windowed()) {
+            show_all_expenses(window, w);
+        } else {
+            show_all_expenses(w);
+        }
     } else if (subcommand == "template") {
         show_templates();
     } else if (subcommand == "add" && args.size() > 2) {
@@ -125,7 +234,7 @@ void budget::expenses_module::handle(const std::vector<std::string>& args){
             expense.name = template_name;
 
             std::string account_name;
-            edit_string_complete(account_name, "Account", all_account_names(), not_empty_checker(), account_checker());
+            edit_string_complete(account_name, "Account", account_completion(), not_empty_checker(), account_checker());
             expense.account = get_account(account_name, expense.date.year(), expense.date.month()).id;
 
             edit_money(expense.amount, "Amount", not_negative_checker(), not_zero_checker());
@@ -145,7 +254,7 @@ void budget::expenses_module::handle(const std::vector<std::string>& args){
 
         edit_date(expense.date, "Date");
 
-        edit_string_complete(account_name, "Account", all_account_names(), not_empty_checker(), account_checker(expense.date));
+        edit_string_complete(account_name, "Account", account_completion(), not_empty_checker(), account_checker(expense.date));
         expense.account = get_account(account_name, expense.date.year(), expense.date.month()).id;
 
         edit_string(expense.name, "Name", not_empty_checker());
@@ -173,7 +282,7 @@ void budget::expenses_module::handle(const std::vector<std::string>& args){
         edit_date(expense.date, "Date");
 
         auto account_name = get_account(expense.account).name;
-        edit_string_complete(account_name, "Account", all_account_names(), not_empty_checker(), account_checker(expense.date));
+        edit_string_complete(account_name, "Account", account_completion(), not_empty_checker(), account_checker(expense.date));
         expense.account = get_account(account_name, expense.date.year(), expense.date.month()).id;
 
         edit_string(expense.name, "Name", not_empty_checker());
@@ -204,10 +313,24 @@ size_t budget::add_expense(budget::expense&& expense){
     return expenses.add(std::move(expense));
 }
 
+std::vector<size_t> budget::add_expenses(std::vector<expense>&& new_expenses){
+    return expenses.add_many(std::move(new_expenses));
+}
+
 bool budget::edit_expense(const expense& expense){
     return expenses.indirect_edit(expense);
 }
 
+void budget::edit_expenses(const std::vector<expense>& edited_expenses){
+    auto batch = expenses.begin_batch();
+
+    for (const auto& expense : edited_expenses) {
+        batch.edit(expense);
+    }
+
+    batch.commit();
+}
+
 void budget::expense::save(data_writer& writer) const {
     writer << id;
     writer << guid;
@@ -247,21 +370,12 @@ void budget::set_expenses_changed(){
 }
 
 void budget::show_all_expenses(budget::writer& w){
-    w << title_begin << "All Expenses " << add_button("expenses") << title_end;
-
-    std::vector<std::string> columns = {"ID", "Date", "Account", "Name", "Amount", "Edit"};
-    std::vector<std::vector<std::string>> contents;
-
-    for (auto& expense : all_expenses()) {
-        contents.push_back({to_string(expense.id),
-                            to_string(expense.date),
-                            get_account(expense.account).name,
-                            expense.name,
-                            to_string(expense.amount),
-                            "::edit::expenses::" + to_string(expense.id)});
-    }
+    show_expenses_listing(all_expenses(), false, w);
+}
 
-    w.display_table(columns, contents);
+void budget::show_all_expenses(const listing_window& window, budget::writer& w){
+    // Only the visible expenses are copied and formatted
+    show_expenses_listing(expenses.window(window), true, w);
 }
 
 void budget::search_expenses(std::string_view search, budget::writer& w){
@@ -273,21 +387,16 @@ void budget::search_expenses(std::string_view search, budget::writer& w){
     money total;
     size_t count = 0;
 
-    for (auto& expense : all_expenses()) {
-        auto it = std::ranges::search(
-                expense.name, search, [](char a, char b) { return std::tolower(a) == std::tolower(b); });
-
-        if (it) {
-            contents.push_back({to_string(expense.id),
-                                to_string(expense.date),
-                                get_account(expense.account).name,
-                                expense.name,
-                                to_string(expense.amount),
-                                "::edit::expenses::" + to_string(expense.id)});
+    for (auto& expense : search_expenses_by_name(search)) {
+        contents.push_back({to_string(expense.id),
+                            to_string(expense.date),
+                            get_account(expense.account).name,
+                            expense.name,
+                            to_string(expense.amount),
+                            "::edit::expenses::" + to_string(expense.id)});
 
-            total += expense.amount;
-            ++count;
-        }
+        total += expense.amount;
+        ++count;
     }
 
     if(count == 0){
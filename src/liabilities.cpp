@@ -55,9 +55,7 @@ std::map<std::string, std::string, std::less<>> budget::liability::get_params()
 }
 
 void budget::liabilities_module::load(){
-    load_liabilities();
-    load_asset_classes();
-    load_asset_values();
+    load_concurrently({load_liabilities, load_asset_classes, load_asset_values});
 }
 
 void budget::liabilities_module::unload(){
@@ -459,7 +457,7 @@ budget::money budget::get_liability_value_conv(const budget::liability& liabilit
     auto amount = get_liability_value(liability, d, cache);
 
     if (amount) {
-        return amount * exchange_rate(liability.currency, d);
+        return amount * exchange_rate(cache.currency(liability.currency), cache.default_currency(), d);
     }
     return amount;
 }
@@ -473,7 +471,7 @@ budget::money budget::get_liability_value_conv(const budget::liability& liabilit
     auto amount = get_liability_value(liability, d, cache);
 
     if (amount) {
-        return amount * exchange_rate(liability.currency, currency, d);
+        return amount * exchange_rate(cache.currency(liability.currency), cache.currency(currency), d);
     }
     return amount;
 }
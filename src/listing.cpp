@@ -0,0 +1,28 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "listing.hpp"
+#include "console.hpp"
+#include "utils.hpp"
+
+budget::listing_window budget::listing_window_option(std::vector<std::string>& args) {
+    listing_window window;
+
+    if (auto limit = option_value("--limit", args, ""); !limit.empty()) {
+        window.limit = to_number<size_t>(limit);
+    }
+
+    if (auto offset = option_value("--offset", args, ""); !offset.empty()) {
+        window.offset = to_number<size_t>(offset);
+    }
+
+    if (auto since = option_value("--since", args, ""); !since.empty()) {
+        window.since = date_from_string(since);
+    }
+
+    return window;
+}
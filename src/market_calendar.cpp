@@ -0,0 +1,160 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "market_calendar.hpp"
+#include "config.hpp"
+#include "date.hpp"
+#include "logging.hpp"
+
+namespace {
+
+struct market_holidays {
+    std::vector<budget::date> dates;                            // Holidays on a specific date
+    std::vector<std::pair<budget::date_type, budget::date_type>> yearly; // Holidays on the same month and day each year
+};
+
+market_holidays parse_holidays(std::string_view config) {
+    market_holidays result;
+
+    for (auto holiday : budget::splitv(config, ',')) {
+        if (holiday.empty()) {
+            continue;
+        }
+
+        try {
+            if (holiday.size() == 5) {
+                result.yearly.emplace_back(budget::to_number<budget::date_type>(holiday.substr(0, 2)),
+                                           budget::to_number<budget::date_type>(holiday.substr(3, 2)));
+            } else {
+                result.dates.push_back(budget::date_from_string(holiday));
+            }
+        } catch (const budget::date_exception&) {
+            LOG_F(ERROR, "Market: Invalid holiday {}", holiday);
+        } catch (const budget::budget_exception&) {
+            LOG_F(ERROR, "Market: Invalid holiday {}", holiday);
+        }
+    }
+
+    std::ranges::sort(result.dates);
+
+    return result;
+}
+
+std::mutex holidays_lock;
+std::string holidays_config;
+std::atomic<size_t> holidays_generation = 0;
+std::atomic<const market_holidays*> current_holidays = nullptr;
+
+// The previous holidays are kept alive, since a reader may still use them.
+// There is one per change of market_holidays, which is rare.
+std::vector<std::unique_ptr<const market_holidays>> parsed_holidays;
+
+// The configuration is only read again once it has changed, and the holidays
+// only parsed again if market_holidays itself changed. Otherwise, this is only
+// two atomic loads, without any lock or allocation.
+const market_holidays& holidays() {
+    const auto generation = budget::config_generation();
+
+    if (holidays_generation.load(std::memory_order_acquire) == generation) [[likely]] {
+        return *current_holidays.load(std::memory_order_acquire);
+    }
+
+    const std::scoped_lock l(holidays_lock);
+
+    if (holidays_generation.load(std::memory_order_relaxed) != generation) {
+        auto config = budget::user_config_value("market_holidays", "");
+
+        if (parsed_holidays.empty() || config != holidays_config) {
+            parsed_holidays.push_back(std::make_unique<const market_holidays>(parse_holidays(config)));
+            holidays_config = std::move(config);
+
+            current_holidays.store(parsed_holidays.back().get(), std::memory_order_release);
+        }
+
+        holidays_generation.store(generation, std::memory_order_release);
+    }
+
+    return *current_holidays.load(std::memory_order_acquire);
+}
+
+std::mutex closed_lock;
+std::chrono::steady_clock::time_point closed_time;
+budget::date closed_day;
+bool closed_computed = false;
+
+budget::date compute_last_closed_trading_day() {
+    const auto now  = std::chrono::system_clock::now();
+    const auto zone = std::chrono::current_zone();
+    const auto time = zone->to_local(now);
+
+    const std::chrono::hh_mm_ss hms{time - std::chrono::floor<std::chrono::days>(time)};
+
+    // We make sure that we are on a new U.S: day
+    // TODO This should be done by getting the current time in the U.S.
+    if (hms.hours().count() > 15) {
+        return budget::last_trading_day(budget::local_day() - budget::days(1));
+    }
+
+    return budget::last_trading_day(budget::local_day() - budget::days(2));
+}
+
+} // end of anonymous namespace
+
+bool budget::is_trading_day(const budget::date& d) {
+    if (auto dow = d.day_of_the_week(); dow == 6 || dow == 7) {
+        return false;
+    }
+
+    const auto& market = holidays();
+
+    if (std::ranges::binary_search(market.dates, d)) {
+        return false;
+    }
+
+    return std::ranges::find(market.yearly, std::pair{d._month, d._day}) == market.yearly.end();
+}
+
+budget::date budget::last_trading_day(const budget::date& d) {
+    auto day = d;
+
+    while (!is_trading_day(day)) {
+        day -= budget::days(1);
+    }
+
+    return day;
+}
+
+budget::date budget::last_closed_trading_day() {
+    const std::scoped_lock l(closed_lock);
+
+    const auto now = std::chrono::steady_clock::now();
+
+    if (!closed_computed || now - closed_time > std::chrono::minutes(1)) {
+        closed_day      = compute_last_closed_trading_day();
+        closed_time     = now;
+        closed_computed = true;
+    }
+
+    return closed_day;
+}
+
+budget::date budget::valid_trading_day(const budget::date& d) {
+    // We cannot get closing price in the future, so we use the last closed day
+    if (d >= budget::local_day()) {
+        return last_closed_trading_day();
+    }
+
+    return last_trading_day(d);
+}
@@ -0,0 +1,141 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <chrono>
+#include <fstream>
+
+#include "negative_cache.hpp"
+#include "config.hpp"
+#include "data.hpp"
+#include "logging.hpp"
+
+namespace {
+
+constexpr const int64_t max_negative_delay = 7 * 24 * 3600;
+
+// An entry expired for longer than the longest delay is forgotten, otherwise
+// every key that failed once would be kept forever
+constexpr const int64_t negative_retention = max_negative_delay;
+
+int64_t now_seconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // end of anonymous namespace
+
+void budget::negative_cache::load() {
+    const auto file_path = budget::path_to_budget_file(path);
+
+    std::ifstream file(file_path);
+
+    if (!file.is_open() || !file.good()) {
+        return;
+    }
+
+    const server_lock_guard l(lock);
+
+    const auto now = now_seconds();
+
+    std::string line;
+    while (file.good() && getline(file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        data_reader reader;
+        reader.parse(line);
+
+        std::string key;
+        int64_t expiry  = 0;
+        size_t failures = 0;
+
+        reader >> key;
+        reader >> expiry;
+        reader >> failures;
+
+        if (expiry + negative_retention < now) {
+            changed = true;
+            continue;
+        }
+
+        // Expired entries are kept for their number of failures, so that the
+        // next delay is longer if the key fails again
+        entries[key] = {expiry, failures};
+
+        if (expiry > now) {
+            LOG_F(INFO, "Negative Cache: {} is negative for {} more seconds", key, expiry - now);
+        }
+    }
+}
+
+void budget::negative_cache::save() {
+    const server_lock_guard l(lock);
+
+    if (!changed) {
+        return;
+    }
+
+    const auto file_path = budget::path_to_budget_file(path);
+
+    std::ofstream file(file_path);
+
+    if (!file.is_open() || !file.good()) {
+        LOG_F(INFO, "Impossible to save Negative Cache to {}", file_path.string());
+        return;
+    }
+
+    const auto now = now_seconds();
+
+    std::erase_if(entries, [now](const auto& entry) { return entry.second.expiry + negative_retention < now; });
+
+    for (const auto& [key, value] : entries) {
+        data_writer writer;
+        writer << key;
+        writer << value.expiry;
+        writer << value.failures;
+        file << writer.to_string() << std::endl;
+    }
+
+    changed = false;
+}
+
+bool budget::negative_cache::contains(std::string_view key) {
+    const server_lock_guard l(lock);
+
+    if (auto it = entries.find(key); it != entries.end()) {
+        return it->second.expiry > now_seconds();
+    }
+
+    return false;
+}
+
+void budget::negative_cache::failure(std::string_view key) {
+    const int64_t base = 60 * to_number<int64_t>(user_config_value("negative_cache_delay", "60"));
+
+    const server_lock_guard l(lock);
+
+    auto& entry = entries[std::string(key)];
+
+    ++entry.failures;
+
+    // Exponential backoff, the shift is bounded to avoid overflows
+    const int64_t delay = std::min(base << std::min<size_t>(entry.failures - 1, 20), max_negative_delay);
+
+    entry.expiry = now_seconds() + delay;
+    changed      = true;
+
+    LOG_F(INFO, "Negative Cache: {} failed {} times, negative for {} seconds", key, entry.failures, delay);
+}
+
+void budget::negative_cache::success(std::string_view key) {
+    const server_lock_guard l(lock);
+
+    if (auto it = entries.find(key); it != entries.end()) {
+        entries.erase(it);
+        changed = true;
+    }
+}
@@ -205,10 +205,7 @@ int budget::compute_success(const budget::status& status, const budget::objectiv
 }
 
 void budget::objectives_module::load(){
-    load_expenses();
-    load_earnings();
-    load_accounts();
-    load_objectives();
+    load_concurrently({load_expenses, load_earnings, load_accounts, load_objectives});
 }
 
 void budget::objectives_module::unload(){
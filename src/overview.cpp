@@ -7,7 +7,12 @@
 
 #include <cstdio>
 #include <cstring>
+#include <map>
 #include <numeric>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -16,6 +21,7 @@
 
 #include "cpp_utils/hash.hpp"
 #include "date.hpp"
+#include "data.hpp"
 #include "overview.hpp"
 #include "console.hpp"
 #include "data_cache.hpp"
@@ -24,6 +30,7 @@
 #include "config.hpp"
 #include "views.hpp"
 #include "writer.hpp"
+#include "parallel.hpp"
 
 using namespace budget;
 
@@ -174,8 +181,6 @@ budget::money compute_total_budget_account(data_cache & cache, const budget::acc
 }
 
 std::vector<budget::money> compute_total_budget(data_cache & cache, budget::month month, budget::year year){
-    cpp::string_hash_map<budget::money> tmp;
-
     // By default, the start is the year of the overview
     auto start_year_report = year;
 
@@ -184,7 +189,12 @@ std::vector<budget::money> compute_total_budget(data_cache & cache, budget::mont
         start_year_report = start_year(cache);
     }
 
-    for(budget::year y = start_year_report; y <= year; ++y){
+    // Each year is computed independently, in its own accumulator
+    auto partials = parallel_map(year.value - start_year_report.value + 1, [&](size_t i) {
+        const budget::year y = start_year_report + budget::date_type(i);
+
+        cpp::string_hash_map<budget::money> partial;
+
         budget::month m = start_month(cache, y);
 
         while(true){
@@ -193,9 +203,9 @@ std::vector<budget::money> compute_total_budget(data_cache & cache, budget::mont
             }
 
             for(const auto& account : all_accounts(cache, y, m)){
-                tmp[account.name] += account.amount;
-                tmp[account.name] -= fold_left_auto(all_expenses_month(cache, account.id, y, m) | to_amount);
-                tmp[account.name] += fold_left_auto(all_earnings_month(cache, account.id, y, m) | to_amount);
+                partial[account.name] += account.amount;
+                partial[account.name] -= fold_left_auto(all_expenses_month(cache, account.id, y, m) | to_amount);
+                partial[account.name] += fold_left_auto(all_earnings_month(cache, account.id, y, m) | to_amount);
             }
 
             if(y != year && m.is_last()){
@@ -204,6 +214,16 @@ std::vector<budget::money> compute_total_budget(data_cache & cache, budget::mont
 
             ++m;
         }
+
+        return partial;
+    });
+
+    cpp::string_hash_map<budget::money> tmp;
+
+    for (const auto& partial : partials) {
+        for (const auto& [name, amount] : partial) {
+            tmp[name] += amount;
+        }
     }
 
     std::vector<budget::money> total_budgets;
@@ -255,52 +275,230 @@ void add_values_column(budget::month                          month,
     add_recap_line(contents, title, total);
 }
 
-using acc_data_t = cpp::string_hash_map<cpp::istring_hash_map<budget::money>>;
-
-template<std::ranges::range R, typename Functor>
-std::pair<budget::money, acc_data_t> aggregate(data_cache & cache, R && data, bool full, bool disable_groups, const std::string& separator, Functor&& func){
+// The amounts of the elements, grouped by account and by group. The account
+// and the group of each element are resolved once into ids, the amounts are
+// then accumulated into a flat array indexed by (account id, group id).
+struct aggregation {
     budget::money total;
-    acc_data_t acc_data;
+    std::vector<std::string> accounts;  // The names of the accounts
+    std::vector<std::string> groups;    // The names of the groups, as first seen
+    std::vector<budget::money> amounts; // By account id, then by group id
+    std::vector<char> present;          // Indicates if a (account, group) has any element
 
-    //Accumulate all the data
-    for (const auto& element : std::forward<R>(data)) {
-        if (func(element)) {
-            auto name = element.name;
+    // The groups of an account, by decreasing amount
+    std::vector<std::pair<std::string, budget::money>> items(std::string_view account) const {
+        std::vector<std::pair<std::string, budget::money>> sorted_items;
+
+        auto it = std::ranges::find(accounts, account);
+
+        if (it == accounts.end()) {
+            return sorted_items;
+        }
+
+        const size_t first = (it - accounts.begin()) * groups.size();
 
-            if (name[name.size() - 1] == ' ') {
-                name.erase(name.size() - 1, name.size());
+        for (size_t g = 0; g < groups.size(); ++g) {
+            if (present[first + g]) {
+                sorted_items.emplace_back(groups[g], amounts[first + g]);
             }
+        }
 
-            if (!disable_groups) {
-                auto loc = name.find(separator);
-                if (loc != std::string::npos) {
-                    name = name.substr(0, loc);
-                }
+        std::ranges::stable_sort(sorted_items, [](const auto& a, const auto& b) { return a.second > b.second; });
+
+        return sorted_items;
+    }
+};
+
+// The amount of an account and a group
+struct element_ids {
+    size_t account;
+    size_t group;
+    budget::money amount;
+};
+
+// The amounts of the elements of a month, by account and group ids local to
+// the month
+struct aggregation_chunk {
+    std::vector<std::string> accounts;
+    std::vector<std::string> groups;
+    std::vector<element_ids> totals; // One per (account, group) of the month
+};
+
+template<typename T>
+aggregation_chunk aggregate_chunk(std::span<const T* const> elements, bool full, bool disable_groups, const std::string& separator){
+    aggregation_chunk chunk;
+
+    cpp::string_hash_map<size_t> account_ids;
+    cpp::istring_hash_map<size_t> group_ids;
+    std::unordered_map<size_t, size_t> account_columns; // By id of account
+
+    // By local account, then by local group, empty when there is no element
+    std::vector<std::vector<std::optional<budget::money>>> amounts;
+
+    auto account_id = [&](std::string_view name) {
+        if (auto it = account_ids.find(name); it != account_ids.end()) {
+            return it->second;
+        }
+
+        const size_t id = chunk.accounts.size();
+        chunk.accounts.emplace_back(name);
+        account_ids.emplace(std::string(name), id);
+        return id;
+    };
+
+    for (const auto* element : elements) {
+        std::string_view name = element->name;
+
+        if (!name.empty() && name.back() == ' ') {
+            name.remove_suffix(1);
+        }
+
+        if (!disable_groups) {
+            if (auto loc = name.find(separator); loc != std::string_view::npos) {
+                name = name.substr(0, loc);
             }
+        }
 
-            if (full) {
-                acc_data["All accounts"][name] += element.amount;
-            } else {
-                auto account = get_account(element.account);
-                acc_data[account.name][name] += element.amount;
+        size_t group = 0;
+        if (auto it = group_ids.find(name); it != group_ids.end()) {
+            group = it->second;
+        } else {
+            group = chunk.groups.size();
+            chunk.groups.emplace_back(name);
+            group_ids.emplace(std::string(name), group);
+        }
+
+        size_t account = 0;
+        if (full) {
+            account = account_id("All accounts");
+        } else if (auto it = account_columns.find(element->account); it != account_columns.end()) {
+            account = it->second;
+        } else {
+            account = account_id(get_account(element->account).name);
+            account_columns[element->account] = account;
+        }
+
+        if (account >= amounts.size()) {
+            amounts.resize(account + 1);
+        }
+
+        if (group >= amounts[account].size()) {
+            amounts[account].resize(chunk.groups.size());
+        }
+
+        auto& amount = amounts[account][group];
+        amount = amount.value_or(budget::money()) + element->amount;
+    }
+
+    for (size_t account = 0; account < amounts.size(); ++account) {
+        for (size_t group = 0; group < amounts[account].size(); ++group) {
+            if (amounts[account][group]) {
+                chunk.totals.push_back({account, group, *amounts[account][group]});
             }
+        }
+    }
+
+    return chunk;
+}
+
+template<std::ranges::range R, typename Functor>
+aggregation aggregate(data_cache & cache, R && data, bool full, bool disable_groups, const std::string& separator, Functor&& func){
+    using element_type = std::remove_cvref_t<std::ranges::range_reference_t<R>>;
+
+    // The elements of each month are resolved by the same thread
+    std::map<int, std::vector<const element_type*>> selected;
 
-            total += element.amount;
+    for (const auto& element : data) {
+        if (func(element)) {
+            selected[int(element.date.year()) * 12 + int(element.date.month())].push_back(&element);
+        }
+    }
+
+    std::vector<std::vector<const element_type*>> months;
+    months.reserve(selected.size());
+
+    for (auto& [key, elements] : selected) {
+        months.push_back(std::move(elements));
+    }
+
+    // The months are aggregated in parallel, only their totals are merged, in
+    // order so that the groups are seen in the order of their dates
+    auto chunks = parallel_map(months.size(), [&](size_t i) {
+        return aggregate_chunk<element_type>(months[i], full, disable_groups, separator);
+    });
+
+    aggregation result;
+
+    cpp::string_hash_map<size_t> account_ids;
+    cpp::istring_hash_map<size_t> group_ids;
+
+    auto account_id = [&](std::string_view name) {
+        if (auto it = account_ids.find(name); it != account_ids.end()) {
+            return it->second;
+        }
+
+        const size_t id = result.accounts.size();
+        result.accounts.emplace_back(name);
+        account_ids.emplace(std::string(name), id);
+        return id;
+    };
+
+    auto group_id = [&](std::string_view name) {
+        if (auto it = group_ids.find(name); it != group_ids.end()) {
+            return it->second;
+        }
+
+        const size_t id = result.groups.size();
+        result.groups.emplace_back(name);
+        group_ids.emplace(std::string(name), id);
+        return id;
+    };
+
+    for (auto& chunk : chunks) {
+        std::vector<size_t> accounts;
+        for (const auto& name : chunk.accounts) {
+            accounts.push_back(account_id(name));
+        }
+
+        std::vector<size_t> groups;
+        for (const auto& name : chunk.groups) {
+            groups.push_back(group_id(name));
+        }
+
+        for (auto& element : chunk.totals) {
+            element.account = accounts[element.account];
+            element.group   = groups[element.group];
         }
     }
 
     for (const auto& account : current_accounts(cache)) {
-        if (!acc_data.contains(account.name)) {
-            acc_data[account.name];
+        account_id(account.name);
+    }
+
+    // Merge the totals of the months
+    const size_t groups = result.groups.size();
+
+    result.amounts.resize(result.accounts.size() * groups);
+    result.present.resize(result.accounts.size() * groups, 0);
+
+    for (const auto& chunk : chunks) {
+        for (const auto& element : chunk.totals) {
+            const size_t index = element.account * groups + element.group;
+
+            result.amounts[index] += element.amount;
+            result.present[index] = 1;
+
+            result.total += element.amount;
         }
     }
 
-    return {total, acc_data};
+    return result;
 }
 
 template<std::ranges::range R, typename Functor>
 void aggregate_overview(R && data, budget::writer& w, bool full, bool disable_groups, const std::string& separator, Functor&& func){
-    auto [total, acc_data] = aggregate(w.cache, std::forward<R>(data), full, disable_groups, separator, func);
+    auto aggregated  = aggregate(w.cache, std::forward<R>(data), full, disable_groups, separator, func);
+    const auto total = aggregated.total;
 
     cpp::string_hash_map<budget::money> totals;
 
@@ -308,25 +506,13 @@ void aggregate_overview(R && data, budget::writer& w, bool full, bool disable_gr
     std::vector<std::vector<std::string>> contents;
 
     for (auto& account : current_accounts(w.cache)) {
-        auto& items = acc_data[account.name];
-
         auto column = columns.size();
         columns.push_back(account.name);
         size_t row = 0;
 
-        using s_items = std::pair<std::string, budget::money>;
-        std::vector<s_items> sorted_data;
-
-        for (auto& [name, amount] : items) {
-            sorted_data.push_back(std::make_pair(name, amount));
-        }
-
-        std::ranges::sort(sorted_data,
-            [](const s_items& a, const s_items& b){ return a.second > b.second; });
-
-        for (auto& [name, amount] : sorted_data) {
+        for (auto& [name, amount] : aggregated.items(account.name)) {
             if(contents.size() <= row){
-                contents.emplace_back(acc_data.size() * 3, "");
+                contents.emplace_back(aggregated.accounts.size() * 3, "");
             }
 
             contents[row][column * 3] = name;
@@ -339,8 +525,8 @@ void aggregate_overview(R && data, budget::writer& w, bool full, bool disable_gr
         }
     }
 
-    contents.emplace_back(acc_data.size() * 3, "");
-    contents.emplace_back(acc_data.size() * 3, "");
+    contents.emplace_back(aggregated.accounts.size() * 3, "");
+    contents.emplace_back(aggregated.accounts.size() * 3, "");
 
     size_t i = 0;
 
@@ -364,7 +550,7 @@ void aggregate_overview_month(R && data, budget::writer& w, bool full, bool disa
         months = 12 - budget::start_month(w.cache, year) + 1;
     }
 
-    auto [total, acc_data] = aggregate(w.cache, std::forward<R>(data), full, disable_groups, separator, func);
+    auto aggregated = aggregate(w.cache, std::forward<R>(data), full, disable_groups, separator, func);
 
     cpp::string_hash_map<budget::money> totals;
 
@@ -372,25 +558,13 @@ void aggregate_overview_month(R && data, budget::writer& w, bool full, bool disa
     std::vector<std::vector<std::string>> contents;
 
     for (auto& account : current_accounts(w.cache)) {
-        auto& items = acc_data[account.name];
-
         auto column = columns.size();
         columns.push_back(account.name);
         size_t row = 0;
 
-        using s_items = std::pair<std::string, budget::money>;
-        std::vector<s_items> sorted_data;
-
-        for (auto& [name, amount] : items) {
-            sorted_data.push_back(std::make_pair(name, amount));
-        }
-
-        std::ranges::sort(sorted_data,
-            [](const s_items& a, const s_items& b){ return a.second > b.second; });
-
-        for (auto& [name, amount] : sorted_data) {
+        for (auto& [name, amount] : aggregated.items(account.name)) {
             if(contents.size() <= row){
-                contents.emplace_back(acc_data.size() * 3, "");
+                contents.emplace_back(aggregated.accounts.size() * 3, "");
             }
 
             contents[row][column * 3] = name;
@@ -403,8 +577,8 @@ void aggregate_overview_month(R && data, budget::writer& w, bool full, bool disa
         }
     }
 
-    contents.emplace_back(acc_data.size() * 3, "");
-    contents.emplace_back(acc_data.size() * 3, "");
+    contents.emplace_back(aggregated.accounts.size() * 3, "");
+    contents.emplace_back(aggregated.accounts.size() * 3, "");
 
     size_t i = 0;
 
@@ -431,7 +605,7 @@ budget::money future_value(budget::money start) {
 
 template<std::ranges::range R, typename Functor>
 void aggregate_overview_fv(R && data, budget::writer& w, bool full, bool disable_groups, const std::string& separator, Functor&& func){
-    auto [total, acc_data] = aggregate(w.cache, std::forward<R>(data), full, disable_groups, separator, func);
+    auto aggregated = aggregate(w.cache, std::forward<R>(data), full, disable_groups, separator, func);
 
     cpp::string_hash_map<budget::money> totals;
 
@@ -439,25 +613,13 @@ void aggregate_overview_fv(R && data, budget::writer& w, bool full, bool disable
     std::vector<std::vector<std::string>> contents;
 
     for (auto& account : current_accounts(w.cache)) {
-        auto& items = acc_data[account.name];
-
         auto column = columns.size();
         columns.push_back(account.name);
         size_t row = 0;
 
-        using s_items = std::pair<std::string, budget::money>;
-        std::vector<s_items> sorted_data;
-
-        for (auto& [name, amount] : items) {
-            sorted_data.push_back(std::make_pair(name, amount));
-        }
-
-        std::ranges::sort(sorted_data,
-            [](const s_items& a, const s_items& b){ return a.second > b.second; });
-
-        for (auto& [name, amount] : sorted_data) {
+        for (auto& [name, amount] : aggregated.items(account.name)) {
             if(contents.size() <= row){
-                contents.emplace_back(acc_data.size() * 3, "");
+                contents.emplace_back(aggregated.accounts.size() * 3, "");
             }
 
             contents[row][column * 3] = name;
@@ -470,8 +632,8 @@ void aggregate_overview_fv(R && data, budget::writer& w, bool full, bool disable
         }
     }
 
-    contents.emplace_back(acc_data.size() * 3, "");
-    contents.emplace_back(acc_data.size() * 3, "");
+    contents.emplace_back(aggregated.accounts.size() * 3, "");
+    contents.emplace_back(aggregated.accounts.size() * 3, "");
 
     size_t i = 0;
 
@@ -646,15 +808,8 @@ void display_values(budget::writer& w, budget::year year, const std::string& tit
 } // end of anonymous namespace
 
 void budget::overview_module::load(){
-    load_accounts();
-    load_incomes();
-    load_expenses();
-    load_earnings();
-
-    // Yearly overview needs net worth data
-    load_earnings();
-    load_fortunes();
-    load_assets();
+    // Yearly overview needs net worth data (fortunes and assets)
+    load_concurrently({load_accounts, load_incomes, load_expenses, load_earnings, load_fortunes, load_assets});
 }
 
 void budget::overview_module::handle(std::vector<std::string>& args) {
@@ -12,6 +12,7 @@
 #include "cpp_utils/assert.hpp"
 
 #include "predict.hpp"
+#include "data.hpp"
 #include "overview.hpp"
 #include "console.hpp"
 #include "accounts.hpp"
@@ -89,9 +90,7 @@ void predict_overview(){
 } // end of anonymous namespace
 
 void budget::predict_module::load() const {
-    load_accounts();
-    load_expenses();
-    load_earnings();
+    load_concurrently({load_accounts, load_expenses, load_earnings});
 }
 
 void budget::predict_module::handle(const std::vector<std::string>& args) const {
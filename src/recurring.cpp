@@ -5,9 +5,14 @@
 //  http://opensource.org/licenses/MIT)
 //=======================================================================
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <map>
+#include <set>
+#include <tuple>
+#include <unordered_map>
 
 #include "recurring.hpp"
 #include "args.hpp"
@@ -31,37 +36,183 @@ data_handler<recurring> recurrings { "recurrings", "recurrings.data" };
 
 const std::vector<std::string> recurrences{"yearly", "bi-yearly", "quarterly", "monthly", "weekly"};
 
-budget::date last_date(const budget::recurring& recurring) {
-    budget::date last(1400, 1, 1);
+// The latest date of the operations matching the recurrings, by (name,
+// amount, account name). The index is built in a single pass over the
+// expenses and the earnings and is shared by all the recurrings.
+struct recurring_index {
+    using key_type = std::tuple<std::string, budget::money, std::string>;
 
-    if (recurring.type == "expense") {
-        for (const auto& expense : all_expenses() | persistent | filter_by_name(recurring.name) | filter_by_amount(recurring.amount)) {
-            if (get_account(expense.account).name == recurring.account && expense.date > last) {
-                last = expense.date;
+    std::map<key_type, budget::date> expenses;
+    std::map<key_type, budget::date> earnings;
+
+    explicit recurring_index(const std::vector<budget::recurring>& all_recurrings) {
+        std::set<std::string, std::less<>> names;
+        for (const auto& recurring : all_recurrings) {
+            names.insert(recurring.name);
+        }
+
+        std::unordered_map<size_t, std::string> account_names;
+        for (const auto& account : all_accounts()) {
+            account_names[account.id] = account.name;
+        }
+
+        for (const auto& expense : all_expenses() | persistent) {
+            if (names.contains(expense.name)) {
+                add(expenses, {expense.name, expense.amount, account_names[expense.account]}, expense.date);
             }
         }
 
-        return last;
+        for (const auto& earning : all_earnings()) {
+            if (names.contains(earning.name)) {
+                add(earnings, {earning.name, earning.amount, account_names[earning.account]}, earning.date);
+            }
+        }
+    }
+
+    budget::date last_date(const budget::recurring& recurring) const {
+        const auto& index = operations(*this, recurring);
+
+        if (auto it = index.find(key(recurring)); it != index.end()) {
+            return it->second;
+        }
+
+        return {1400, 1, 1};
+    }
+
+    bool not_triggered(const budget::recurring& recurring) const {
+        return last_date(recurring).year() == budget::year(1400);
+    }
+
+    // Operations generated during this run must be seen by the next recurrings
+    void generated(const budget::recurring& recurring, const budget::date& date) {
+        add(operations(*this, recurring), key(recurring), date);
+    }
+
+private:
+    static key_type key(const budget::recurring& recurring) {
+        return {recurring.name, recurring.amount, recurring.account};
+    }
+
+    static void add(std::map<key_type, budget::date>& index, key_type&& key, const budget::date& date) {
+        if (auto [it, inserted] = index.try_emplace(std::move(key), date); !inserted && date > it->second) {
+            it->second = date;
+        }
     }
 
-    if (recurring.type == "earning") {
-        for (const auto& earning : all_earnings() | filter_by_name(recurring.name) | filter_by_amount(recurring.amount)) {
-            if (get_account(earning.account).name == recurring.account && earning.date > last) {
-                last = earning.date;
+    // The return type cannot be deduced, this is used before its definition
+    template <typename Index>
+    static auto operations(Index& index, const budget::recurring& recurring) -> decltype((index.expenses)) {
+        if (recurring.type == "expense") {
+            return index.expenses;
+        }
+
+        if (recurring.type == "earning") {
+            return index.earnings;
+        }
+
+        throw budget_exception("Invalid recurring type " + recurring.type);
+    }
+};
+
+// The next due date of each recurring, persisted between runs, so that
+// nothing has to be indexed when no recurring is due. A date is only valid
+// for the exact recurring it was computed for, an edited recurring is
+// scheduled again from its operations.
+struct recurring_schedule {
+    struct entry {
+        std::string recurring; // The serialized recurring
+        budget::date next;
+    };
+
+    std::map<size_t, entry> entries;
+    bool changed = false;
+
+    void load() {
+        entries.clear();
+
+        std::ifstream file(budget::path_to_budget_file("recurrings.schedule"));
+
+        std::string line;
+        while (file.good() && getline(file, line)) {
+            if (line.empty()) {
+                continue;
             }
+
+            data_reader reader;
+            reader.parse(line);
+
+            size_t id = 0;
+            entry e;
+
+            reader >> id;
+            reader >> e.next;
+            reader >> e.recurring;
+
+            entries[id] = std::move(e);
+        }
+    }
+
+    void save() {
+        if (!changed) {
+            return;
         }
 
-        return last;
+        std::ofstream file(budget::path_to_budget_file("recurrings.schedule"));
+
+        for (const auto& [id, e] : entries) {
+            data_writer writer;
+            writer << id;
+            writer << e.next;
+            writer << e.recurring;
+            file << writer.to_string() << std::endl;
+        }
+
+        changed = false;
     }
 
-    throw budget_exception("Invalid recurring type " + recurring.type);
-}
+    bool is_due(const budget::recurring& recurring, const budget::date& now) const {
+        if (auto it = entries.find(recurring.id); it != entries.end() && it->second.recurring == serialize(recurring)) {
+            return it->second.next < now;
+        }
 
-bool recurring_not_triggered(const budget::recurring & recurring ) {
-    return last_date(recurring).year() == budget::year(1400);
-}
+        return true;
+    }
+
+    void set(const budget::recurring& recurring, const budget::date& next) {
+        entries[recurring.id] = {serialize(recurring), next};
+        changed = true;
+    }
+
+    // Forget the recurrings that do not exist anymore
+    void prune(const std::vector<budget::recurring>& all_recurrings) {
+        changed |= std::erase_if(entries, [&all_recurrings](const auto& e) {
+            return std::ranges::none_of(all_recurrings, [&e](const auto& recurring) { return recurring.id == e.first; });
+        }) > 0;
+    }
+
+private:
+    static std::string serialize(const budget::recurring& recurring) {
+        data_writer writer;
+        recurring.save(writer);
+        return writer.to_string();
+    }
+};
+
+// The operations generated for all the recurrings, added together
+struct generated_operations {
+    std::vector<budget::expense> expenses;
+    std::vector<budget::earning> earnings;
+
+    void flush() {
+        add_expenses(std::move(expenses));
+        add_earnings(std::move(earnings));
 
-bool generate_recurring(const budget::date & date, const recurring & recurring) {
+        expenses.clear();
+        earnings.clear();
+    }
+};
+
+bool generate_recurring(const budget::date & date, const recurring & recurring, generated_operations & generated, recurring_index & index) {
     if (recurring.type == "expense") {
         budget::expense recurring_expense;
 
@@ -71,7 +222,7 @@ bool generate_recurring(const budget::date & date, const recurring & recurring)
         recurring_expense.amount  = recurring.amount;
         recurring_expense.name    = recurring.name;
 
-        add_expense(std::move(recurring_expense));
+        generated.expenses.push_back(std::move(recurring_expense));
     } else if (recurring.type == "earning") {
         budget::earning recurring_earning;
 
@@ -81,16 +232,49 @@ bool generate_recurring(const budget::date & date, const recurring & recurring)
         recurring_earning.amount  = recurring.amount;
         recurring_earning.name    = recurring.name;
 
-        add_earning(std::move(recurring_earning));
+        generated.earnings.push_back(std::move(recurring_earning));
     } else {
         throw budget_exception("Invalid recurring type " + recurring.type);
     }
 
+    index.generated(recurring, date);
+
     return true;
 }
 
 } //end of anonymous namespace
 
+budget::date budget::next_due_date(const budget::recurring& recurring, const budget::date& last) {
+    if (recurring.recurs == "yearly") {
+        return budget::date(last.year(), 1, 1) + budget::years(1);
+    }
+
+    if (recurring.recurs == "bi-yearly") {
+        return budget::date(last.year(), last.month(), 1) + budget::months(6);
+    }
+
+    if (recurring.recurs == "quarterly") {
+        return budget::date(last.year(), last.month(), 1) + budget::months(3);
+    }
+
+    if (recurring.recurs == "monthly") {
+        return budget::date(last.year(), last.month(), 1) + budget::months(1);
+    }
+
+    if (recurring.recurs == "weekly") {
+        auto next = last.start_of_week() + budget::days(7);
+
+        // The last week of the year is skipped since it's incomplete
+        while (next.week() == 53) {
+            next += budget::days(7);
+        }
+
+        return next;
+    }
+
+    cpp_unreachable("Invalid recurrence");
+}
+
 std::map<std::string, std::string, std::less<>> budget::recurring::get_params()  const {
     std::map<std::string, std::string, std::less<>> params;
 
@@ -117,15 +301,40 @@ void budget::check_for_recurrings(){
 
     bool changed = false;
 
-    for (auto& recurring : recurrings.data()) {
+    const auto all_recurrings = recurrings.data();
+
+    recurring_schedule schedule;
+    schedule.load();
+    schedule.prune(all_recurrings);
+
+    std::vector<budget::recurring> due;
+    for (const auto& recurring : all_recurrings) {
+        if (schedule.is_due(recurring, now)) {
+            due.push_back(recurring);
+        }
+    }
+
+    // In the common case, nothing is due and the operations are not needed
+    if (due.empty()) {
+        LOG_F(INFO, "recurrings: No recurring is due");
+
+        schedule.save();
+        internal_config_remove("recurring:last_checked");
+        return;
+    }
+
+    recurring_index index(due);
+    generated_operations generated;
+
+    for (auto& recurring : due) {
         if (recurring.recurs == "yearly") {
-            if (recurring_not_triggered(recurring)) {
+            if (index.not_triggered(recurring)) {
                 // If the recurring has never been created, we create it for
                 // the first time at the beginning of the current year
 
-                changed |= generate_recurring({now.year(), 1, 1}, recurring);
+                changed |= generate_recurring({now.year(), 1, 1}, recurring, generated, index);
             } else {
-                auto last = last_date(recurring);
+                auto last = index.last_date(recurring);
 
                 // If the recurring has already been triggered, we trigger again
                 // for each of the missing years
@@ -134,22 +343,22 @@ void budget::check_for_recurrings(){
                 recurring_date += budget::years(1);
 
                 while (recurring_date < now) {
-                    changed |= generate_recurring(recurring_date, recurring);
+                    changed |= generate_recurring(recurring_date, recurring, generated, index);
 
                     // Get to the next year
                     recurring_date += budget::years(1);
                 }
             }
         } else if (recurring.recurs == "bi-yearly") {
-            if (recurring_not_triggered(recurring)) {
+            if (index.not_triggered(recurring)) {
                 // If the recurring has never been created, we create it for
                 // the first time at the beginning of the current semester
 
                 date_type semester_start = 6 * ((now.month() - date_type(1)) / 6) + 1;
 
-                changed |= generate_recurring({now.year(), semester_start, 1}, recurring);
+                changed |= generate_recurring({now.year(), semester_start, 1}, recurring, generated, index);
             } else {
-                auto last = last_date(recurring);
+                auto last = index.last_date(recurring);
 
                 // If the recurring has already been triggered, we trigger again
                 // for each of the missing quarters
@@ -158,22 +367,22 @@ void budget::check_for_recurrings(){
                 recurring_date += budget::months(6);
 
                 while (recurring_date < now) {
-                    changed |= generate_recurring(recurring_date, recurring);
+                    changed |= generate_recurring(recurring_date, recurring, generated, index);
 
                     // Get to the next quarter
                     recurring_date += budget::months(6);
                 }
             }
         } else if (recurring.recurs == "quarterly") {
-            if (recurring_not_triggered(recurring)) {
+            if (index.not_triggered(recurring)) {
                 // If the recurring has never been created, we create it for
                 // the first time at the beginning of the current quarter
 
                 date_type quarter_start = 3 * ((now.month() - date_type(1)) / 3) + 1;
 
-                changed |= generate_recurring({now.year(), quarter_start, 1}, recurring);
+                changed |= generate_recurring({now.year(), quarter_start, 1}, recurring, generated, index);
             } else {
-                auto last = last_date(recurring);
+                auto last = index.last_date(recurring);
 
                 // If the recurring has already been triggered, we trigger again
                 // for each of the missing quarters
@@ -182,22 +391,22 @@ void budget::check_for_recurrings(){
                 recurring_date += budget::months(3);
 
                 while (recurring_date < now) {
-                    changed |= generate_recurring(recurring_date, recurring);
+                    changed |= generate_recurring(recurring_date, recurring, generated, index);
 
                     // Get to the next quarter
                     recurring_date += budget::months(3);
                 }
             }
         } else if (recurring.recurs == "monthly") {
-            if (recurring_not_triggered(recurring)) {
+            if (index.not_triggered(recurring)) {
                 // If the recurring has never been created, we create it for
                 // the first time at the time of today
 
-                changed |= generate_recurring({now.year(), now.month(), 1}, recurring);
+                changed |= generate_recurring({now.year(), now.month(), 1}, recurring, generated, index);
 
                 LOG_F(INFO, "recurrings: Created first instance of {}", recurring.id);
             } else {
-                auto last = last_date(recurring);
+                auto last = index.last_date(recurring);
 
                 LOG_F(INFO, "recurrings: Last date of {} is {}", recurring.id, budget::to_string(last));
 
@@ -210,25 +419,25 @@ void budget::check_for_recurrings(){
                 LOG_F(INFO, "recurrings: Next instance of {} is {}", recurring.id, budget::to_string(recurring_date));
 
                 while (recurring_date < now) {
-                    changed |= generate_recurring(recurring_date, recurring);
+                    changed |= generate_recurring(recurring_date, recurring, generated, index);
 
                     // Get to the next month
                     recurring_date += budget::months(1);
                 }
             }
         } else if (recurring.recurs == "weekly") {
-            if (recurring_not_triggered(recurring)) {
+            if (index.not_triggered(recurring)) {
                 // If the recurring has never been created, we create it for
                 // the first time at the time of today
 
                 if (now.week() == 53) {
                     // We do not create recurring expenses in week 52 (53-1)
-                    changed |= generate_recurring((now - days(7)).start_of_week(), recurring);
+                    changed |= generate_recurring((now - days(7)).start_of_week(), recurring, generated, index);
                 } else {
-                    changed |= generate_recurring(now.start_of_week(), recurring);
+                    changed |= generate_recurring(now.start_of_week(), recurring, generated, index);
                 }
             } else {
-                auto last = last_date(recurring);
+                auto last = index.last_date(recurring);
 
                 // Note: The start_of_week() is only necessary because the user
                 // could have created a matching expense in an arbitrary date
@@ -237,7 +446,7 @@ void budget::check_for_recurrings(){
                 while (recurring_date < now) {
                     // We skip the last week of the year since it's incomplete
                     if (recurring_date.week() < 53) {
-                        changed |= generate_recurring(recurring_date, recurring);
+                        changed |= generate_recurring(recurring_date, recurring, generated, index);
                     }
 
                     // Advance by one week
@@ -247,8 +456,15 @@ void budget::check_for_recurrings(){
         } else {
             cpp_unreachable("Invalid recurrence");
         }
+
+        schedule.set(recurring, next_due_date(recurring, index.last_date(recurring)));
     }
 
+    // The missing operations of all the recurrings are added at once
+    generated.flush();
+
+    schedule.save();
+
     if (changed) {
         save_expenses();
         save_earnings();
@@ -274,9 +490,7 @@ void budget::recurring_module::preload() {
 void budget::recurring_module::load() {
     // Only need to load in server mode
     if (is_server_mode()) {
-        load_recurrings();
-        load_accounts();
-        load_expenses();
+        load_concurrently({load_recurrings, load_accounts, load_expenses});
     }
 }
 
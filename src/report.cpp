@@ -8,6 +8,7 @@
 #include <iostream>
 
 #include "report.hpp"
+#include "data.hpp"
 #include "expenses.hpp"
 #include "earnings.hpp"
 #include "budget_exception.hpp"
@@ -43,10 +44,7 @@ void write(graph_type& graph, long row, long col, const std::string& value) {
 } //end of anonymous namespace
 
 void budget::report_module::load() {
-    load_accounts();
-    load_expenses();
-    load_earnings();
-    load_incomes();
+    load_concurrently({load_accounts, load_expenses, load_earnings, load_incomes});
 }
 
 void budget::report_module::handle(const std::vector<std::string>& args) {
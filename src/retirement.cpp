@@ -7,8 +7,13 @@
 
 #include <iostream>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
 
 #include "data_cache.hpp"
+#include "data.hpp"
 #include "retirement.hpp"
 #include "assets.hpp"
 #include "accounts.hpp"
@@ -19,72 +24,229 @@
 #include "console.hpp"
 #include "writer.hpp"
 #include "incomes.hpp"
+#include "parallel.hpp"
+#include "running_series.hpp"
 
 using namespace budget;
 
 namespace {
 
-constexpr size_t running_limit = 12;
+// The months to reach the goal from the current net worth, saving the given
+// part of the income
+std::optional<size_t> months_to_fi(const money& nw, double roi, double savings_rate, const money& income, const money& goal) {
+    const projection nw_projection{double(nw), (roi / 100.0) / 12, double(savings_rate * income) / 12};
 
-money running_expenses(data_cache & cache, const budget::date & date = budget::local_day()){
-    budget::date const end = date.previous_month().end_of_month();                     // The end is the last day of the previous month
-    budget::date const start = (end - budget::months(running_limit)).start_of_month(); // The start is N months before the end date
+    return nw_projection.months_to(double(goal));
+}
+
+// Describe the time to FI of a scenario, compared to the current one
+void write_scenario(budget::writer& w, const std::optional<size_t>& base_months, const std::optional<size_t>& months, std::string_view adjusted = "") {
+    if (!months) {
+        w << "not be enough to reach FI";
+    } else if (!base_months) {
+        w << "allow to reach FI (in " << double(*months) / 12.0 << adjusted << " years)";
+    } else {
+        w << "save " << (double(*base_months) - double(*months)) / 12.0 << " years (in " << double(*months) / 12.0 << adjusted << " years)";
+    }
+}
 
-    budget::money total;
+constexpr size_t simulation_chunk_paths = 256;
+constexpr size_t never                  = std::numeric_limits<size_t>::max();
 
-    if (auto & expenses = cache.sorted_expenses(); !expenses.empty()) {
-        auto it = ranges::lower_bound(expenses.begin(), expenses.end(), start, ranges::less{}, [](const auto & value) { return value.date; });
+struct simulation_chunk {
+    std::vector<double> values; ///< The net worth at the end of each year, path after path
+    std::vector<size_t> months; ///< The months to reach the target of each path
+};
 
-        while (it != expenses.end()) {
-            if (it->date <= end) {
-                if (it->is_persistent()) {
-                    total += it->amount;
-                }
+simulation_chunk simulate_chunk(const simulation_parameters& parameters, size_t chunk) {
+    const size_t first = chunk * simulation_chunk_paths;
+    const size_t paths = std::min(simulation_chunk_paths, parameters.paths - first);
+
+    // Each chunk has its own stream of random numbers
+    std::seed_seq seeds{uint32_t(parameters.seed), uint32_t(parameters.seed >> 32), uint32_t(chunk)};
+    std::mt19937_64 generator(seeds);
+
+    std::normal_distribution<double> normal(parameters.mean_return / 12, parameters.volatility > 0.0 ? parameters.volatility / std::sqrt(12.0) : 1.0);
+    std::uniform_int_distribution<size_t> history(0, parameters.monthly_returns.empty() ? 0 : parameters.monthly_returns.size() - 1);
+
+    auto monthly_return = [&]() {
+        if (!parameters.monthly_returns.empty()) {
+            return parameters.monthly_returns[history(generator)];
+        }
+
+        if (parameters.volatility <= 0.0) {
+            return parameters.mean_return / 12;
+        }
+
+        return normal(generator);
+    };
+
+    simulation_chunk result;
+    result.values.reserve(paths * parameters.years);
+    result.months.reserve(paths);
+
+    for (size_t path = 0; path < paths; ++path) {
+        double net_worth = parameters.net_worth;
+        size_t reached   = net_worth >= parameters.target ? 0 : never;
+
+        for (size_t month = 1; month <= parameters.years * 12; ++month) {
+            net_worth = net_worth * (1.0 + monthly_return()) + parameters.monthly_savings;
+
+            if (reached == never && net_worth >= parameters.target) {
+                reached = month;
+            }
 
-                ++it;
-            } else {
-                break;
+            if (month % 12 == 0) {
+                result.values.push_back(net_worth);
             }
         }
+
+        result.months.push_back(reached);
     }
 
-    return total;
+    return result;
+}
+
+// The value at the given percentile, the values are reordered
+template <typename T>
+T percentile(std::vector<T>& values, double p) {
+    auto nth = values.begin() + ptrdiff_t(p * double(values.size() - 1));
+
+    std::ranges::nth_element(values, nth);
+
+    return *nth;
 }
 
-double running_savings_rate(data_cache & cache, const budget::date & sd = budget::local_day()){
-    double savings_rate = 0.0;
+// The monthly returns of the FI net worth, without the savings of the month.
+// The savings that do not end up in the FI assets lower the returns, this is
+// only an approximation of the returns of the portfolio.
+std::vector<double> historical_returns(data_cache& cache) {
+    std::vector<double> returns;
+
+    auto& values = cache.sorted_asset_values();
+
+    if (values.empty()) {
+        return returns;
+    }
+
+    const auto last = budget::local_day().previous_month().end_of_month();
 
-    for(date_type i = 1; i <= running_limit; ++i){
-        auto d = sd - budget::months(i);
+    auto d        = values.front().set_date.end_of_month();
+    auto previous = get_fi_net_worth(d, cache);
 
+    while (d < last) {
+        d = (d.start_of_month() + budget::months(1)).end_of_month();
+
+        auto nw       = get_fi_net_worth(d, cache);
         auto expenses = fold_left_auto(all_expenses_month(cache, d.year(), d.month()) | to_amount);
         auto earnings = fold_left_auto(all_earnings_month(cache, d.year(), d.month()) | to_amount);
-        auto income   = get_base_income(cache, d);
-
-        auto balance = income + earnings - expenses;
-        auto local   = balance / (income + earnings);
+        auto savings  = get_base_income(cache, d) + earnings - expenses;
 
-        if(local < 0){
-            local = 0;
+        if (previous.value > 0) {
+            returns.push_back((double(nw) - double(previous) - double(savings)) / double(previous));
         }
 
-        savings_rate += local;
+        previous = nw;
     }
 
-    return savings_rate / running_limit;
+    return returns;
 }
 
-budget::money running_income(data_cache & cache, const budget::date & sd = budget::local_day()){
-    budget::money income;
+void retirement_simulate(budget::writer& w, std::vector<std::string>& args) {
+    if (!internal_config_contains("withdrawal_rate") || !internal_config_contains("expected_roi")) {
+        w << "Not enough information, please configure first with retirement set" << end_of_line;
+        return;
+    }
 
-    for(date_type i = 1; i <= running_limit; ++i){
-        auto d = sd - budget::months(i);
+    const auto currency     = get_default_currency();
+    const auto wrate        = to_number<double>(internal_config_value("withdrawal_rate"));
+    const auto roi          = to_number<double>(internal_config_value("expected_roi"));
+    const auto today        = budget::local_day();
+    const auto running      = running_series(w.cache, today, today);
+    const auto savings_rate = running.savings_rate(0);
+    const auto income       = running.income(0);
+    const auto nw           = get_fi_net_worth(w.cache);
+    const auto goal         = (100.0 / wrate) * running.expenses(0);
+
+    simulation_parameters parameters;
+    parameters.net_worth       = double(nw);
+    parameters.monthly_savings = double(savings_rate * income) / 12;
+    parameters.target          = double(goal);
+    parameters.mean_return     = roi / 100.0;
+    parameters.volatility      = to_number<double>(option_value("--volatility", args, user_config_value("retirement_volatility", "15"))) / 100.0;
+    parameters.years           = to_number<size_t>(option_value("--years", args, "30"));
+    parameters.paths           = to_number<size_t>(option_value("--paths", args, "10000"));
+
+    if (auto seed = option_value("--seed", args, ""); !seed.empty()) {
+        parameters.seed = to_number<uint64_t>(seed);
+    } else {
+        parameters.seed = std::random_device{}();
+    }
 
-        auto earnings = fold_left_auto(all_earnings_month(cache, d.year(), d.month()) | to_amount);
-        income += get_base_income(cache, d) + earnings;
+    if (option("--bootstrap", args)) {
+        parameters.monthly_returns = historical_returns(w.cache);
+
+        if (parameters.monthly_returns.empty()) {
+            throw budget_exception("Not enough history of the net worth to bootstrap the returns");
+        }
     }
 
-    return income;
+    if (args.size() > 2) {
+        throw budget_exception("Invalid arguments to retirement simulate");
+    }
+
+    if (!parameters.paths || !parameters.years) {
+        throw budget_exception("The number of paths and of years must be positive");
+    }
+
+    const auto start  = std::chrono::steady_clock::now();
+    const auto result = simulate_retirement(parameters);
+    const auto time   = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::string> columns = {};
+    std::vector<std::vector<std::string>> contents;
+
+    using namespace std::string_literals;
+
+    auto to_string_months = [](const std::optional<size_t>& months) {
+        return months ? to_string(*months / 12.0) : "Never"s;
+    };
+
+    if (parameters.monthly_returns.empty()) {
+        contents.push_back({"Returns"s, to_string(roi) + "% +/- " + to_string(100.0 * parameters.volatility) + "%"});
+    } else {
+        contents.push_back({"Returns"s, "Bootstrapped from " + to_string(parameters.monthly_returns.size()) + " months"});
+    }
+
+    contents.push_back({"Paths"s, to_string(parameters.paths)});
+    contents.push_back({"Seed"s, to_string(parameters.seed)});
+    contents.push_back({"Current Net Worth"s, to_string(nw) + " " + currency});
+    contents.push_back({"Target Net Worth"s, to_string(goal) + " " + currency});
+    contents.push_back({"Yearly savings"s, to_string(savings_rate * income) + " " + currency});
+
+    contents.push_back({""s, ""s});
+    contents.push_back({"Probability of FI in " + to_string(parameters.years) + " years", to_string(100.0 * result.success) + "%"});
+    contents.push_back({"Years to FI (10%)"s, to_string_months(result.months_to_target[0])});
+    contents.push_back({"Years to FI (50%)"s, to_string_months(result.months_to_target[1])});
+    contents.push_back({"Years to FI (90%)"s, to_string_months(result.months_to_target[2])});
+
+    w.display_table(columns, contents);
+
+    std::vector<std::string> path_columns = {"Year", "10%", "50%", "90%"};
+    std::vector<std::vector<std::string>> path_contents;
+
+    for (size_t year = 0; year < result.net_worth.size(); ++year) {
+        auto& values = result.net_worth[year];
+
+        path_contents.push_back({to_string(year + 1),
+                                 to_string(money::from_double(values[0])),
+                                 to_string(money::from_double(values[1])),
+                                 to_string(money::from_double(values[2]))});
+    }
+
+    w.display_table(path_columns, path_contents);
+
+    w << p_begin << "Simulated " << parameters.paths << " paths in " << 1000.0 * time << "ms (" << double(parameters.paths) / time << " paths/s)" << p_end;
 }
 
 void retirement_set() {
@@ -110,10 +272,7 @@ void retirement_set() {
 } // end of anonymous namespace
 
 void budget::retirement_module::load() {
-    load_accounts();
-    load_assets();
-    load_expenses();
-    load_earnings();
+    load_concurrently({load_accounts, load_assets, load_expenses, load_earnings});
 }
 
 void budget::retirement_module::handle(std::vector<std::string>& args) {
@@ -130,14 +289,118 @@ void budget::retirement_module::handle(std::vector<std::string>& args) {
             retirement_set();
             std::cout << std::endl;
             retirement_status(w);
+        } else if (subcommand == "simulate") {
+            retirement_simulate(w, args);
         } else {
             throw budget_exception("Invalid subcommand \"" + subcommand + "\"");
         }
     }
 }
 
+budget::simulation_result budget::simulate_retirement(const simulation_parameters& parameters) {
+    const size_t chunks = (parameters.paths + simulation_chunk_paths - 1) / simulation_chunk_paths;
+
+    auto simulated = parallel_map(chunks, [&parameters](size_t chunk) { return simulate_chunk(parameters, chunk); });
+
+    simulation_result result;
+
+    std::vector<size_t> months;
+    months.reserve(parameters.paths);
+
+    for (auto& chunk : simulated) {
+        months.insert(months.end(), chunk.months.begin(), chunk.months.end());
+    }
+
+    result.success = double(std::ranges::count_if(months, [](size_t m) { return m != never; })) / double(months.size());
+
+    const std::array<double, 3> percentiles{0.1, 0.5, 0.9};
+
+    for (size_t i = 0; i < percentiles.size(); ++i) {
+        if (auto m = percentile(months, percentiles[i]); m != never) {
+            result.months_to_target[i] = m;
+        }
+    }
+
+    std::vector<double> values(parameters.paths);
+
+    for (size_t year = 0; year < parameters.years; ++year) {
+        size_t path = 0;
+
+        for (auto& chunk : simulated) {
+            for (size_t i = year; i < chunk.values.size(); i += parameters.years) {
+                values[path++] = chunk.values[i];
+            }
+        }
+
+        auto& net_worth = result.net_worth.emplace_back();
+
+        for (size_t i = 0; i < percentiles.size(); ++i) {
+            net_worth[i] = percentile(values, percentiles[i]);
+        }
+    }
+
+    return result;
+}
+
+double budget::projection::value(size_t months) const {
+    if (monthly_return == 0.0) {
+        return net_worth + monthly_savings * double(months);
+    }
+
+    const double growth = std::pow(1.0 + monthly_return, double(months));
+
+    return net_worth * growth + monthly_savings * (growth - 1.0) / monthly_return;
+}
+
+std::optional<size_t> budget::projection::months_to(double target) const {
+    if (net_worth >= target) {
+        return 0;
+    }
+
+    double months = 0.0;
+
+    if (monthly_return == 0.0) {
+        if (monthly_savings <= 0.0) {
+            return std::nullopt;
+        }
+
+        months = (target - net_worth) / monthly_savings;
+    } else {
+        // Shifted by savings / return, the net worth is a geometric sequence
+        const double shift = monthly_savings / monthly_return;
+
+        if (net_worth + shift == 0.0) {
+            return std::nullopt;
+        }
+
+        const double ratio = (target + shift) / (net_worth + shift);
+
+        if (ratio <= 0.0) {
+            return std::nullopt;
+        }
+
+        months = std::log(ratio) / std::log1p(monthly_return);
+    }
+
+    // A negative or infinite number of months means it is never reached
+    if (!std::isfinite(months) || months < 0.0) {
+        return std::nullopt;
+    }
+
+    auto result = size_t(std::ceil(months));
+
+    // Correct the rounding errors of the logarithms
+    if (result > 0 && value(result - 1) >= target) {
+        --result;
+    } else if (value(result) < target) {
+        ++result;
+    }
+
+    return result;
+}
+
 double budget::fi_ratio(const budget::date & d, data_cache& cache) {
-    return fixed_fi_ratio(d, cache, running_expenses(cache, d));
+    return fixed_fi_ratio(d, cache, running_series(cache, d, d).expenses(0));
 }
 
 double budget::fixed_fi_ratio(const budget::date& d, data_cache& cache, const money& expenses) {
@@ -171,26 +434,17 @@ void budget::retirement_status(budget::writer& w, const budget::money & fi_expen
     const auto wrate        = to_number<double>(internal_config_value("withdrawal_rate"));
     const auto roi          = to_number<double>(internal_config_value("expected_roi"));
     const auto years        = double(100.0 / wrate);
-    const auto savings_rate = running_savings_rate(w.cache);
+    const auto today        = budget::local_day();
+    const auto running      = running_series(w.cache, today, today);
+    const auto savings_rate = running.savings_rate(0);
     const auto nw           = get_fi_net_worth(w.cache);
-    const auto income       = running_income(w.cache);
+    const auto income       = running.income(0);
 
-    const auto run_expenses     = running_expenses(w.cache);
+    const auto run_expenses     = running.expenses(0);
     const auto run_goal         = years * run_expenses;
     const auto run_missing      = run_goal - nw;
 
-    date_type run_base_months = 0;
-    {
-        auto current_nw = nw;
-        while (current_nw < run_goal) {
-            current_nw *= 1.0 + (roi / 100.0) / 12;
-            current_nw += (savings_rate * income) / 12;
-
-            ++run_base_months;
-        }
-    }
-
-    auto run_fi_date = budget::local_day() + budget::months(run_base_months);
+    const auto run_base_months = months_to_fi(nw, roi, savings_rate, income, run_goal);
 
     std::vector<std::string> columns = {};
     std::vector<std::vector<std::string>> contents;
@@ -216,9 +470,13 @@ void budget::retirement_status(budget::writer& w, const budget::money & fi_expen
         contents.push_back({"Target Net Worth"s, to_string(run_goal) + " " + currency});
         contents.push_back({"Missing Net Worth"s, to_string(run_missing) + " " + currency});
         contents.push_back({"FI Ratio"s, to_string(100 * (nw / run_goal)) + "%"});
-        contents.push_back({"Months to FI"s, to_string(run_base_months)});
-        contents.push_back({"Years to FI"s, to_string(run_base_months / 12.0)});
-        contents.push_back({"Date to FI"s, to_string(run_fi_date)});
+        if (run_base_months) {
+            contents.push_back({"Months to FI"s, to_string(*run_base_months)});
+            contents.push_back({"Years to FI"s, to_string(*run_base_months / 12.0)});
+            contents.push_back({"Date to FI"s, to_string(budget::local_day() + budget::months(date_type(*run_base_months)))});
+        } else {
+            contents.push_back({"Months to FI"s, "Never"s});
+        }
         contents.push_back({"Current Withdrawal Rate"s, to_string(100.0 * (run_expenses / nw)) + "%"});
         contents.push_back({"Months of FI"s, to_string(nw / (run_expenses / 12))});
         contents.push_back({"Years of FI"s, to_string(nw / run_expenses)});
@@ -229,18 +487,7 @@ void budget::retirement_status(budget::writer& w, const budget::money & fi_expen
         const auto fi_goal         = years * fi_expenses;
         const auto fi_missing      = fi_goal - nw;
 
-        date_type fi_base_months = 0;
-        {
-            auto current_nw = nw;
-            while (current_nw < fi_goal) {
-                current_nw *= 1.0 + (roi / 100.0) / 12;
-                current_nw += (savings_rate * income) / 12;
-
-                ++fi_base_months;
-            }
-        }
-
-        auto fi_fi_date = budget::local_day() + budget::months(fi_base_months);
+        const auto fi_base_months = months_to_fi(nw, roi, savings_rate, income, fi_goal);
 
         contents.push_back({""s, ""s});
         contents.push_back({"Target expense"s, ""s});
@@ -248,9 +495,13 @@ void budget::retirement_status(budget::writer& w, const budget::money & fi_expen
         contents.push_back({"Target Net Worth"s, to_string(fi_goal) + " " + currency});
         contents.push_back({"Missing Net Worth"s, to_string(fi_missing) + " " + currency});
         contents.push_back({"FI Ratio"s, to_string(100 * (nw / fi_goal)) + "%"});
-        contents.push_back({"Months to FI"s, to_string(fi_base_months)});
-        contents.push_back({"Years to FI"s, to_string(fi_base_months / 12.0)});
-        contents.push_back({"Date to FI"s, to_string(fi_fi_date)});
+        if (fi_base_months) {
+            contents.push_back({"Months to FI"s, to_string(*fi_base_months)});
+            contents.push_back({"Years to FI"s, to_string(*fi_base_months / 12.0)});
+            contents.push_back({"Date to FI"s, to_string(budget::local_day() + budget::months(date_type(*fi_base_months)))});
+        } else {
+            contents.push_back({"Months to FI"s, "Never"s});
+        }
         contents.push_back({"Current Withdrawal Rate"s, to_string(100.0 * (fi_expenses / nw)) + "%"});
         contents.push_back({"Months of FI"s, to_string(nw / (fi_expenses / 12))});
         contents.push_back({"Years of FI"s, to_string(nw / fi_expenses)});
@@ -267,39 +518,25 @@ void budget::retirement_status(budget::writer& w, const budget::money & fi_expen
     // Note: this not totally correct since we ignore the
     // correlation between the savings rate and the expenses
 
-    for (auto dec : rate_decs) {
-        auto dec_savings_rate = savings_rate + 0.01 * dec;
-
-        auto current_nw = nw;
-        size_t months   = 0;
+    // Each scenario is solved directly, without iterating over the months
 
-        while (current_nw < run_goal) {
-            current_nw *= 1.0 + (roi / 100.0) / 12;
-            current_nw += (dec_savings_rate * income) / 12;
-
-            ++months;
-        }
+    for (auto dec : rate_decs) {
+        auto months = months_to_fi(nw, roi, savings_rate + 0.01 * dec, income, run_goal);
 
-        w << p_begin << "Increasing Savings Rate by " << dec << "% would save " << double(run_base_months - months) / 12.0 << " years (in " << double(months) / 12.0
-          << " years)" << p_end;
+        w << p_begin << "Increasing Savings Rate by " << dec << "% would ";
+        write_scenario(w, run_base_months, months);
+        w << p_end;
     }
 
     const std::array<int, 5> exp_decs{10, 50, 100, 200, 500};
 
     for (auto dec : exp_decs) {
-        auto current_nw = nw;
-        size_t months   = 0;
-
         auto new_savings_rate = (income - (run_expenses - dec * 12)) / income;
 
-        while (current_nw < years * (run_expenses - (dec * 12))) {
-            current_nw *= 1.0 + (roi / 100.0) / 12;
-            current_nw += (new_savings_rate * income) / 12;
-
-            ++months;
-        }
+        auto months = months_to_fi(nw, roi, new_savings_rate, income, years * (run_expenses - (dec * 12)));
 
-        w << p_begin << "Decreasing monthly expenses by " << dec << " " << currency << " would save " << double(run_base_months - months) / 12.0 << " years (in "
-          << double(months) / 12.0 << " (adjusted) years)" << p_end;
+        w << p_begin << "Decreasing monthly expenses by " << dec << " " << currency << " would ";
+        write_scenario(w, run_base_months, months, " (adjusted)");
+        w << p_end;
     }
 }
@@ -0,0 +1,131 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <algorithm>
+
+#include "running_series.hpp"
+#include "data_cache.hpp"
+#include "incomes.hpp"
+
+using namespace budget;
+
+namespace {
+
+// The running expenses go from the start of the month before the same month
+// of the previous year, one more month than the other running metrics
+constexpr size_t history = running_limit + 1;
+
+int months_between(const budget::date& from, const budget::date& to) {
+    return (int(to.year()) - int(from.year())) * 12 + int(to.month()) - int(from.month());
+}
+
+// Each month is computed from the first date, so that the day of the month is
+// kept as much as possible
+budget::date month_date(const budget::date& first, int offset) {
+    if (offset < 0) {
+        return first - budget::months(date_type(-offset));
+    }
+
+    return first + budget::months(date_type(offset));
+}
+
+} // end of anonymous namespace
+
+budget::running_series::running_series(data_cache& cache, const budget::date& first, const budget::date& last) : cache_(&cache) {
+    if (last < first) {
+        return;
+    }
+
+    const size_t points = size_t(months_between(first, last)) + 1;
+    const size_t total_months = history + points - 1;
+
+    dates_.reserve(points);
+
+    for (size_t i = 0; i < points; ++i) {
+        dates_.push_back(month_date(first, int(i)));
+    }
+
+    std::vector<budget::money> totals(total_months);
+
+    const auto start = month_date(first, -int(history)).start_of_month();
+    const auto end   = month_date(first, int(points) - 2).end_of_month();
+
+    auto& expenses = cache.sorted_expenses();
+
+    for (auto it = std::ranges::lower_bound(expenses, start, std::ranges::less{}, [](const auto& value) { return value.date; });
+         it != expenses.end() && it->date <= end; ++it) {
+        if (it->is_persistent()) {
+            totals[size_t(months_between(start, it->date))] += it->amount;
+        }
+    }
+
+    expenses_.resize(total_months + 1);
+
+    for (size_t j = 0; j < total_months; ++j) {
+        expenses_[j + 1] = expenses_[j] + totals[j];
+    }
+}
+
+void budget::running_series::compute_income() const {
+    if (!income_.empty() || dates_.empty()) {
+        return;
+    }
+
+    const auto& first = dates_.front();
+
+    const size_t total_months = history + size() - 1;
+
+    const auto start = month_date(first, -int(history)).start_of_month();
+    const auto end   = month_date(first, int(size()) - 2).end_of_month();
+
+    std::vector<budget::money> earnings(total_months);
+
+    auto& sorted_earnings = cache_->sorted_earnings();
+
+    for (auto it = std::ranges::lower_bound(sorted_earnings, start, std::ranges::less{}, [](const auto& value) { return value.date; });
+         it != sorted_earnings.end() && it->date <= end; ++it) {
+        earnings[size_t(months_between(start, it->date))] += it->amount;
+    }
+
+    income_.resize(total_months + 1);
+    savings_rate_.resize(total_months + 1);
+
+    for (size_t j = 0; j < total_months; ++j) {
+        // The first month is only used by the running expenses
+        const auto income  = j ? get_base_income(*cache_, month_date(first, int(j) - int(history))) : budget::money();
+        const auto revenue = income + earnings[j];
+
+        // A month without any income has no savings, a division by zero
+        // would spoil all the following sums
+        double local = 0.0;
+
+        if (revenue) {
+            local = std::max(0.0, (revenue - (expenses_[j + 1] - expenses_[j])) / revenue);
+        }
+
+        income_[j + 1]       = income_[j] + revenue;
+        savings_rate_[j + 1] = savings_rate_[j] + local;
+    }
+}
+
+// The i-th month is at history + i, its window ends at the month before
+
+budget::money budget::running_series::expenses(size_t i) const {
+    return expenses_[i + history] - expenses_[i];
+}
+
+budget::money budget::running_series::income(size_t i) const {
+    compute_income();
+
+    return income_[i + history] - income_[i + 1];
+}
+
+double budget::running_series::savings_rate(size_t i) const {
+    compute_income();
+
+    return (savings_rate_[i + history] - savings_rate_[i + 1]) / running_limit;
+}
@@ -9,7 +9,7 @@
 
 #include <math.h>
 
-#include <chrono>
+#include <format>
 #include <iostream>
 #include <map>
 #include <set>
@@ -25,8 +25,11 @@
 #include "date.hpp"
 #include "http.hpp"
 #include "logging.hpp"
+#include "market_calendar.hpp"
 #include "money.hpp"
+#include "negative_cache.hpp"
 #include "server_lock.hpp"
+#include "single_flight.hpp"
 
 namespace {
 
@@ -47,33 +50,24 @@ struct share_cache_value {
     bool valid{};
 };
 
-std::map<share_price_cache_key, share_cache_value, std::less<>> share_prices;
-budget::server_lock shares_lock;
-
-budget::date get_valid_date(const budget::date & d){
-    // We cannot get closing price in the future, so we use the day before date
-    if (d >= budget::local_day()) {
-        const auto now  = std::chrono::system_clock::now();
-        const auto zone = std::chrono::current_zone();
-        const auto time = zone->to_local(now);
+using share_price_quotes = std::map<share_price_cache_key, budget::money, std::less<>>;
 
-        const std::chrono::hh_mm_ss hms{time - std::chrono::floor<std::chrono::days>(time)};
-
-        // We make sure that we are on a new U.S: day
-        // TODO This should be done by getting the current time in the U.S.
-        if (hms.hours().count() > 15) {
-            return get_valid_date(budget::local_day() - budget::days(1));
-        }
+// The result of one call to the quote provider, with the window it covers
+struct share_price_fetch {
+    budget::date start_date;
+    budget::date end_date;
+    share_price_quotes quotes;
+};
 
-        return get_valid_date(budget::local_day() - budget::days(2));
-    }
+std::map<share_price_cache_key, share_cache_value, std::less<>> share_prices;
+budget::server_lock shares_lock;
 
-    if (auto dow = d.day_of_the_week(); dow == 6 || dow == 7){
-        return get_valid_date(d - budget::days(dow - 5));
-    }
+// Fetches in flight, by ticker
+budget::single_flight<std::string, share_price_fetch> share_price_fetches;
 
-    return d;
-}
+// The months of the tickers for which no quotes were found recently
+budget::negative_cache share_negatives{"share_price.negative"};
+budget::cache_counters share_counters;
 
 // When we do not find a value for a ticker, we need to find an invalid value
 // In the worst case, we use a value of 1, but sometimes we can do better
@@ -103,7 +97,7 @@ share_cache_value get_invalid_value(const share_price_cache_key & key) {
 // V3 is using Yahoo Finance
 // Starting from this version, the get_share_price function must be thread
 // safe. This means, it cannot touch the cache itself
-std::map<share_price_cache_key, budget::money, std::less<>> get_share_price_v3(const std::string & ticker, budget::date start_date, budget::date end_date) {
+share_price_quotes get_share_price_v3(const std::string & ticker, budget::date start_date, budget::date end_date) {
     std::string const command =
         "yfinance_quote.py " + ticker + " " + date_to_string(start_date) + " " + date_to_string(end_date);
 
@@ -115,7 +109,7 @@ std::map<share_price_cache_key, budget::money, std::less<>> get_share_price_v3(c
         return {};
     }
 
-    std::map<share_price_cache_key, budget::money, std::less<>> quotes;
+    share_price_quotes quotes;
 
     std::stringstream ss(result);
 
@@ -143,9 +137,43 @@ std::map<share_price_cache_key, budget::money, std::less<>> get_share_price_v3(c
     return quotes;
 }
 
+// The tickers are negative by month, a month without any quote (before the
+// IPO for instance) must not prevent the lookups in the other months
+std::string negative_key(const std::string& ticker, budget::date date) {
+    return std::format("{}/{}-{:02}", ticker, date.year().value, date.month().value);
+}
+
+// Several server threads can miss on the same ticker at the same time.
+// Instead of spawning one process per thread, they all wait on the same
+// fetch, as long as its window covers the date they are interested in.
+// The outcome is recorded once, by the fetch itself
+share_price_quotes fetch_share_prices(const std::string& ticker, budget::date date, budget::date start_date, budget::date end_date) {
+    while (true) {
+        auto fetch = share_price_fetches.run(ticker, [&ticker, date, start_date, end_date]() {
+            auto quotes = get_share_price_v3(ticker, start_date, end_date);
+
+            // If the API did not find anything, the ticker is invalid, at
+            // least for this date
+            if (quotes.empty()) {
+                share_negatives.failure(negative_key(ticker, date));
+            } else {
+                share_negatives.success(negative_key(ticker, date));
+            }
+
+            return share_price_fetch{start_date, end_date, std::move(quotes)};
+        });
+
+        if (fetch.start_date <= date && date <= fetch.end_date) {
+            return fetch.quotes;
+        }
+    }
+}
+
 } // end of anonymous namespace
 
 void budget::load_share_price_cache(){
+    share_negatives.load();
+
     const auto file_path = budget::path_to_budget_file("share_price.cache");
 
     std::ifstream file(file_path);
@@ -186,6 +214,8 @@ void budget::load_share_price_cache(){
 }
 
 void budget::save_share_price_cache() {
+    share_negatives.save();
+
     const auto file_path = budget::path_to_budget_file("share_price.cache");
 
     std::ofstream file(file_path);
@@ -209,8 +239,15 @@ void budget::save_share_price_cache() {
         }
     }
 
+    const auto stats = share_counters.stats();
+
     LOG_F(INFO, "Share Price Cache has been saved to {}", file_path.string());
     LOG_F(INFO, "Share Price Cache has {} entries", share_prices.size());
+    LOG_F(INFO, "Share Price Cache: {} hits, {} misses, {} negative hits", stats.hits, stats.misses, stats.negative_hits);
+}
+
+budget::cache_stats budget::share_price_cache_stats() {
+    return share_counters.stats();
 }
 
 void budget::prefetch_share_price_cache(){
@@ -243,38 +280,61 @@ budget::money budget::share_price(const std::string& ticker){
 }
 
 budget::money budget::share_price(const std::string& ticker, budget::date d){
-    if (d > budget::local_day()) {
+    const auto today = budget::local_day();
+
+    if (d > today) {
         LOG_F(ERROR,
               "Asking for a share price {} in the future ({}), this should not happen",
               ticker,
               budget::to_string(d));
     }
 
-    auto date = get_valid_date(d);
+    // The first step is to get the data from the cache. A past trading day is
+    // its own valid trading day, so most lookups do not need the calendar.
 
-    const share_price_cache_key key(date, ticker);
+    if (d < today) {
+        const server_lock_guard l(shares_lock);
 
-    // The first step is to get the data from the cache
+        if (auto it = share_prices.find(share_price_cache_key(d, ticker)); it != share_prices.end()) {
+            ++share_counters.hits;
+            return it->second.value;
+        }
+    }
 
-    {
+    auto date = budget::valid_trading_day(d);
+
+    const share_price_cache_key key(date, ticker);
+
+    if (date != d) {
         const server_lock_guard l(shares_lock);
 
-        if (share_prices.contains(key)) {
-            return share_prices[key].value;
+        if (auto it = share_prices.find(key); it != share_prices.end()) {
+            ++share_counters.hits;
+            return it->second.value;
         }
     }
 
+    // Do not spawn the quote process again for a ticker that failed recently
+    if (share_negatives.contains(negative_key(ticker, date))) {
+        ++share_counters.negative_hits;
+
+        const server_lock_guard l(shares_lock);
+
+        share_prices[key] = get_invalid_value(key);
+        return share_prices[key].value;
+    }
+
+    ++share_counters.misses;
+
     // Note: we use a range for two reasons
     // 1) Handle potential holidays, so we have a range in the past
     // 2) Opportunistically grab several quotes in the past and future to save on API calls
     auto start_date = date - budget::days(10);
     auto end_date   = date + budget::days(10);
-    auto quotes     = get_share_price_v3(ticker, start_date, end_date);
+    auto quotes     = fetch_share_prices(ticker, date, start_date, end_date);
 
     const server_lock_guard l(shares_lock);
 
-    // If the API did not find anything, it must mean that the ticker is
-    // invalid
     if (quotes.empty()) {
         LOG_F(ERROR,
               "Price: Could not find quotes for {} for date {} ({}-{})",
@@ -291,19 +351,15 @@ budget::money budget::share_price(const std::string& ticker, budget::date d){
         share_prices[new_key] = {new_value, true};
     }
 
-    // If it has not been found, it may be a holiday, so we try to get
-    // back in time to find a proper value
+    // If it has not been found, it may be a holiday that is not in the
+    // calendar, so we use the last quote before the date
     if (!share_prices.contains(key)) {
-        for (size_t i = 0; i < 4; ++i){
-            auto next_date = get_valid_date(date - budget::days(1));
+        if (auto it = quotes.lower_bound(key); it != quotes.begin()) {
+            --it;
 
-            LOG_F(INFO, "Price: Possible holiday on {}, retrying on {}", budget::to_string(date), budget::to_string(next_date));
+            LOG_F(INFO, "Price: Possible holiday on {}, using {}", budget::to_string(date), budget::to_string(it->first.date));
 
-            const share_price_cache_key next_key(next_date, ticker);
-            if (share_prices.contains(next_key)) {
-                share_prices[key] = share_prices[next_key];
-                break;
-            }
+            share_prices[key] = {it->second, true};
         }
     }
 
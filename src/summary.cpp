@@ -13,6 +13,7 @@
 #include "cpp_utils/hash.hpp"
 
 #include "data_cache.hpp"
+#include "data.hpp"
 #include "summary.hpp"
 #include "console.hpp"
 #include "compute.hpp"
@@ -148,11 +149,7 @@ void month_overview() {
 } // end of anonymous namespace
 
 void budget::summary_module::load() {
-    load_accounts();
-    load_expenses();
-    load_earnings();
-    load_objectives();
-    load_fortunes();
+    load_concurrently({load_accounts, load_expenses, load_earnings, load_objectives, load_fortunes});
 }
 
 void budget::summary_module::handle(std::vector<std::string>& args) {
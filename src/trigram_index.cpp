@@ -0,0 +1,97 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <algorithm>
+#include <iterator>
+
+#include "trigram_index.hpp"
+#include "utils.hpp"
+
+namespace {
+
+uint32_t trigram(std::string_view text, size_t i) {
+    return uint32_t(static_cast<unsigned char>(text[i])) << 16
+           | uint32_t(static_cast<unsigned char>(text[i + 1])) << 8
+           | uint32_t(static_cast<unsigned char>(text[i + 2]));
+}
+
+std::vector<uint32_t> trigrams(std::string_view text) {
+    std::vector<uint32_t> result;
+
+    for (size_t i = 0; i + 3 <= text.size(); ++i) {
+        result.push_back(trigram(text, i));
+    }
+
+    std::ranges::sort(result);
+    auto [first, last] = std::ranges::unique(result);
+    result.erase(first, last);
+
+    return result;
+}
+
+} // end of anonymous namespace
+
+void budget::trigram_index::add(std::string_view text) {
+    const size_t position = texts_.size();
+
+    texts_.push_back(to_lower(text));
+
+    // The positions are added in increasing order, the lists stay sorted
+    for (auto gram : trigrams(texts_.back())) {
+        postings_[gram].push_back(position);
+    }
+}
+
+std::vector<size_t> budget::trigram_index::search(std::string_view needle) const {
+    const auto lower = to_lower(needle);
+
+    std::vector<size_t> result;
+
+    // Too short to have a trigram, every text is verified
+    if (lower.size() < 3) {
+        for (size_t i = 0; i < texts_.size(); ++i) {
+            if (texts_[i].find(lower) != std::string::npos) {
+                result.push_back(i);
+            }
+        }
+
+        return result;
+    }
+
+    std::vector<const std::vector<size_t>*> lists;
+
+    for (auto gram : trigrams(lower)) {
+        auto it = postings_.find(gram);
+
+        if (it == postings_.end()) {
+            return result;
+        }
+
+        lists.push_back(&it->second);
+    }
+
+    // Start from the rarest trigram, to keep the candidates as few as possible
+    std::ranges::sort(lists, {}, [](auto* list) { return list->size(); });
+
+    std::vector<size_t> candidates = *lists.front();
+    std::vector<size_t> next;
+
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+        next.clear();
+        std::ranges::set_intersection(candidates, *lists[i], std::back_inserter(next));
+        candidates.swap(next);
+    }
+
+    // Having all the trigrams does not mean they are in the right order
+    for (auto position : candidates) {
+        if (texts_[position].find(lower) != std::string::npos) {
+            result.push_back(position);
+        }
+    }
+
+    return result;
+}
@@ -8,6 +8,7 @@
 #include <cstdio>
 #include <fstream>
 #include <cstdint>
+#include <cctype>
 
 #include <unistd.h>
 #ifdef _WIN32
@@ -101,6 +102,16 @@ std::vector<std::string_view> budget::splitv(std::string_view s, char delim) {
     return elems;
 }
 
+std::string budget::to_lower(std::string_view text) {
+    std::string lower(text);
+
+    for (auto& c : lower) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    return lower;
+}
+
 std::string budget::base64_decode(std::string_view in) {
     // table from '+' to 'z'
     const uint8_t lookup[] = {
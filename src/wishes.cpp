@@ -102,17 +102,11 @@ std::map<std::string, std::string, std::less<>> budget::wish::get_params() const
 }
 
 void budget::wishes_module::load(){
-    load_expenses();
-    load_earnings();
-    load_accounts();
-
-    // Need to load both to make sure to have the correct information
-    load_assets();
-    load_fortunes();
+    // Need to load assets and fortunes to make sure to have the correct information
+    load_concurrently({load_expenses, load_earnings, load_accounts, load_assets, load_fortunes});
 
     // Need to be loaded last
-    load_objectives();
-    load_wishes();
+    load_concurrently({load_objectives, load_wishes});
 }
 
 void budget::wishes_module::unload(){
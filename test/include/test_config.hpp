@@ -0,0 +1,75 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "config.hpp"
+
+/*!
+ * \brief Replace the global configuration by a configuration file in a
+ * temporary folder, which is also the data directory. The previous
+ * configuration is restored on destruction.
+ */
+struct temporary_config {
+    using values_type = std::vector<std::pair<std::string, std::string>>;
+
+    explicit temporary_config(const std::string& name, const values_type& values = {})
+            : folder(std::filesystem::temp_directory_path() / name) {
+        if (auto* config_home = std::getenv("XDG_CONFIG_HOME")) {
+            previous_config_home = config_home;
+        }
+
+        std::filesystem::create_directories(folder / "budget");
+
+        setenv("XDG_CONFIG_HOME", folder.c_str(), 1);
+
+        set(values);
+    }
+
+    temporary_config(const temporary_config&) = delete;
+    temporary_config& operator=(const temporary_config&) = delete;
+
+    ~temporary_config() {
+        if (previous_config_home) {
+            setenv("XDG_CONFIG_HOME", previous_config_home->c_str(), 1);
+        } else {
+            unsetenv("XDG_CONFIG_HOME");
+        }
+
+        budget::reload_config();
+    }
+
+    /*!
+     * \brief Replace the values of the configuration
+     */
+    void set(const values_type& values) {
+        {
+            std::ofstream config(folder / "budget" / "budgetrc");
+
+            config << "directory=" << folder.string() << std::endl;
+
+            for (const auto& [key, value] : values) {
+                config << key << "=" << value << std::endl;
+            }
+        }
+
+        budget::load_config();
+    }
+
+    const std::filesystem::path folder;
+
+private:
+    std::optional<std::string> previous_config_home;
+};
@@ -0,0 +1,368 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <set>
+#include <thread>
+
+#include "test.hpp"
+#include "test_config.hpp"
+#include "api.hpp"
+#include "config.hpp"
+#include "data.hpp"
+#include "http.hpp"
+
+namespace {
+
+struct item {
+    size_t      id;
+    std::string guid;
+    std::string name;
+
+    std::map<std::string, std::string, std::less<>> get_params() const {
+        std::map<std::string, std::string, std::less<>> params;
+
+        params["input_id"]   = budget::to_string(id);
+        params["input_guid"] = guid;
+        params["input_name"] = name;
+
+        return params;
+    }
+
+    void load(budget::data_reader& reader) {
+        reader >> id;
+        reader >> guid;
+        reader >> name;
+    }
+
+    void save(budget::data_writer& writer) const {
+        writer << id;
+        writer << guid;
+        writer << name;
+    }
+};
+
+// A stand-in for the budget server, the handlers are set by each test
+struct server_stub {
+    httplib::Server server;
+    std::thread thread;
+    int port = 0;
+
+    server_stub() {
+        port = server.bind_to_any_port("127.0.0.1");
+    }
+
+    void start() {
+        thread = std::thread([this]() { server.listen_after_bind(); });
+
+        while (!server.is_running()) {
+            std::this_thread::yield();
+        }
+    }
+
+    ~server_stub() {
+        server.stop();
+
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+};
+
+// Point the configuration to the stand-in server, in server mode
+void set_server_mode(temporary_config& config, bool server_mode, int port, bool compression = true) {
+    config.set({{"server_mode", server_mode ? "true" : "false"},
+                {"server_url", "127.0.0.1"},
+                {"server_port", budget::to_string(port)},
+                {"server_compression", compression ? "true" : "false"}});
+}
+
+budget::data_handler<item> items_a("items_a", "items_a.data");
+budget::data_handler<item> items_b("items_b", "items_b.data");
+budget::data_handler<item> items_c("items_c", "items_c.data");
+budget::data_handler<item> items_d("items_d", "items_d.data");
+
+} // end of anonymous namespace
+
+TEST_CASE("api/keep_alive") {
+    server_stub stub;
+    temporary_config config("budget_test_api");
+
+    std::set<int> ports;
+
+    // A new connection would come from another port
+    stub.server.Get("/api/ping/", [&ports](const httplib::Request& req, httplib::Response& res) {
+        ports.insert(req.remote_port);
+        res.set_content("pong", "text/plain");
+    });
+
+    stub.server.set_keep_alive_max_count(100);
+
+    stub.start();
+
+    set_server_mode(config, true, stub.port);
+
+    for (size_t i = 0; i < 10; ++i) {
+        auto res = budget::api_get("/ping/");
+
+        FAST_CHECK_UNARY(res.success);
+        FAST_CHECK_EQ(res.result, std::string("pong"));
+    }
+
+    set_server_mode(config, false, stub.port);
+
+    // The sequential requests all reuse the same connection
+    FAST_CHECK_EQ(ports.size(), 1UL);
+}
+
+TEST_CASE("api/add_many") {
+    server_stub stub;
+    temporary_config config("budget_test_api");
+
+    std::atomic<size_t> requests = 0;
+
+    stub.server.Post("/api/items/add/many/", [&requests](const httplib::Request& req, httplib::Response& res) {
+        ++requests;
+
+        const auto count = budget::to_number<size_t>(req.get_param_value("input_count"));
+
+        std::string ids;
+        for (size_t i = 0; i < count; ++i) {
+            if (req.get_param_value(std::format("entry{}_input_name", i)) != std::format("item{}", i)) {
+                res.status = 400;
+                return;
+            }
+
+            ids += (i ? "," : "") + budget::to_string(100 + i);
+        }
+
+        res.set_content(ids, "text/plain");
+    });
+
+    stub.start();
+
+    set_server_mode(config, true, stub.port);
+
+    budget::data_handler<item> items("items", "items.data");
+
+    std::vector<item> entries;
+    for (size_t i = 0; i < 3; ++i) {
+        entries.push_back({0, "guid", std::format("item{}", i)});
+    }
+
+    auto ids = items.add_many(std::move(entries));
+
+    set_server_mode(config, false, stub.port);
+
+    FAST_CHECK_EQ(requests.load(), 1UL);
+    FAST_CHECK_EQ(ids.size(), 3UL);
+    FAST_CHECK_EQ(ids[0], 100UL);
+    FAST_CHECK_EQ(ids[2], 102UL);
+    FAST_CHECK_EQ(items.size(), 3UL);
+    FAST_CHECK_EQ(items[101].name, std::string("item1"));
+}
+
+TEST_CASE("api/list_since") {
+    server_stub stub;
+    temporary_config config("budget_test_api");
+
+    std::vector<std::string> versions;
+
+    stub.server.Get("/api/items/list/since/", [&versions](const httplib::Request& req, httplib::Response& res) {
+        const auto version = req.get_param_value("version");
+        versions.push_back(version);
+
+        if (version == "0") {
+            res.set_content("5:full\n+1:guid:a\n+2:guid:b\n", "text/plain");
+        } else {
+            // The changes apply in order, an entry removed and then added
+            // again is kept, an entry added and then removed is not
+            res.set_content("6\n+3:guid:c\n-2\n+2:guid:bb\n-1\n+4:guid:d\n-4\n", "text/plain");
+        }
+    });
+
+    stub.start();
+
+    set_server_mode(config, true, stub.port);
+
+    std::filesystem::remove(budget::path_to_budget_file("items.data.replica"));
+
+    // The first load downloads everything and creates the replica
+    budget::data_handler<item> first("items", "items.data");
+    first.load();
+
+    // The second load only downloads the changes since the replica
+    budget::data_handler<item> second("items", "items.data");
+    second.load();
+
+    set_server_mode(config, false, stub.port);
+
+    FAST_CHECK_EQ(versions.size(), 2UL);
+    FAST_CHECK_EQ(versions[0], std::string("0"));
+    FAST_CHECK_EQ(versions[1], std::string("5"));
+
+    FAST_CHECK_EQ(first.size(), 2UL);
+    FAST_CHECK_EQ(second.size(), 2UL);
+    FAST_CHECK_UNARY(!second.exists(1));
+    FAST_CHECK_UNARY(!second.exists(4));
+    FAST_CHECK_EQ(second[2].name, std::string("bb"));
+    FAST_CHECK_EQ(second[3].name, std::string("c"));
+    FAST_CHECK_EQ(second.next_id, 4UL);
+}
+
+TEST_CASE("api/replica_fallback") {
+    server_stub stub;
+    temporary_config config("budget_test_api");
+
+    size_t calls = 0;
+
+    // Only the first list succeeds, then the server fails and then it answers
+    // invalid changes
+    stub.server.Get("/api/items/list/since/", [&calls](const httplib::Request&, httplib::Response& res) {
+        if (++calls == 1) {
+            res.set_content("2:full\n+1:guid:a\n+2:guid:b\n", "text/plain");
+        } else if (calls == 2) {
+            res.status = 500;
+        } else {
+            res.set_content("invalid\n", "text/plain");
+        }
+    });
+
+    stub.start();
+
+    set_server_mode(config, true, stub.port);
+
+    std::filesystem::remove(budget::path_to_budget_file("items.data.replica"));
+
+    budget::data_handler<item> first("items", "items.data");
+    first.load();
+
+    // The replica is used when the changes cannot be downloaded
+    budget::data_handler<item> failed("items", "items.data");
+    failed.load();
+
+    budget::data_handler<item> invalid("items", "items.data");
+    invalid.load();
+
+    set_server_mode(config, false, stub.port);
+
+    FAST_CHECK_EQ(calls, 3UL);
+
+    FAST_CHECK_EQ(failed.size(), 2UL);
+    FAST_CHECK_EQ(failed[2].name, std::string("b"));
+    FAST_CHECK_EQ(failed.next_id, 3UL);
+
+    FAST_CHECK_EQ(invalid.size(), 2UL);
+    FAST_CHECK_EQ(invalid[1].name, std::string("a"));
+}
+
+TEST_CASE("api/load_concurrently") {
+    server_stub stub;
+    temporary_config config("budget_test_api");
+
+    std::atomic<size_t> in_flight = 0;
+    std::atomic<bool> overlapped  = false;
+
+    // Each list is slow enough for the other request to arrive while it runs
+    auto handler = [&](const httplib::Request&, httplib::Response& res) {
+        if (++in_flight > 1) {
+            overlapped = true;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        --in_flight;
+
+        res.set_content("1:full\n+1:guid:a\n", "text/plain");
+    };
+
+    stub.server.Get("/api/items_a/list/since/", handler);
+    stub.server.Get("/api/items_b/list/since/", handler);
+
+    stub.start();
+
+    set_server_mode(config, true, stub.port);
+
+    budget::load_concurrently({[]() { items_a.load(); }, []() { items_b.load(); }});
+
+    set_server_mode(config, false, stub.port);
+
+    FAST_CHECK_UNARY(overlapped.load());
+    FAST_CHECK_EQ(items_a.size(), 1UL);
+    FAST_CHECK_EQ(items_b.size(), 1UL);
+}
+
+TEST_CASE("api/list_streaming") {
+    server_stub stub;
+    temporary_config config("budget_test_api");
+
+    // The lines are split over several chunks, the last one has no newline
+    stub.server.Get("/api/items_c/list/since/", [](const httplib::Request&, httplib::Response& res) {
+        res.set_chunked_content_provider("text/plain", [](size_t, httplib::DataSink& sink) {
+            for (std::string_view chunk : {"3:fu", "ll\n+1:gu", "id:a\n", "+2:guid:b"}) {
+                sink.write(chunk.data(), chunk.size());
+            }
+
+            sink.done();
+            return true;
+        });
+    });
+
+    stub.start();
+
+    set_server_mode(config, true, stub.port);
+
+    std::filesystem::remove(budget::path_to_budget_file("items_c.data.replica"));
+
+    items_c.load();
+
+    set_server_mode(config, false, stub.port);
+
+    FAST_CHECK_EQ(items_c.size(), 2UL);
+    FAST_CHECK_EQ(items_c[1].name, std::string("a"));
+    FAST_CHECK_EQ(items_c[2].name, std::string("b"));
+    FAST_CHECK_EQ(items_c.next_id, 3UL);
+}
+
+TEST_CASE("api/compression") {
+    server_stub stub;
+    temporary_config config("budget_test_api");
+
+    std::vector<std::string> encodings;
+
+    stub.server.Get("/api/items_d/list/since/", [&encodings](const httplib::Request& req, httplib::Response& res) {
+        encodings.push_back(req.get_header_value("Accept-Encoding"));
+
+        std::string body = "1000:full\n";
+        for (size_t i = 1; i <= 1000; ++i) {
+            body += std::format("+{}:guid:item{}\n", i, i);
+        }
+
+        res.set_content(body, "text/plain");
+    });
+
+    stub.start();
+
+    for (bool compression : {true, false}) {
+        set_server_mode(config, true, stub.port, compression);
+
+        std::filesystem::remove(budget::path_to_budget_file("items_d.data.replica"));
+
+        items_d.load();
+
+        FAST_CHECK_EQ(items_d.size(), 1000UL);
+        FAST_CHECK_EQ(items_d[1000].name, std::string("item1000"));
+    }
+
+    set_server_mode(config, false, stub.port);
+
+    FAST_CHECK_EQ(encodings.size(), 2UL);
+    FAST_CHECK_EQ(encodings[0], std::string("gzip, deflate"));
+    FAST_CHECK_EQ(encodings[1], std::string("identity"));
+}
@@ -0,0 +1,125 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+#include "test.hpp"
+#include "test_config.hpp"
+#include "autosave.hpp"
+#include "data.hpp"
+
+namespace {
+
+struct entry {
+    size_t      id;
+    std::string name;
+
+    std::map<std::string, std::string, std::less<>> get_params() const {
+        return {{"input_id", budget::to_string(id)}, {"input_name", name}};
+    }
+
+    void load(budget::data_reader& reader) {
+        reader >> id;
+        reader >> name;
+    }
+
+    void save(budget::data_writer& writer) const {
+        writer << id;
+        writer << name;
+    }
+};
+
+constexpr size_t durable_entries = 10;
+
+const temporary_config::values_type durability_values{{"autosave_delay", "100"}};
+
+} // end of anonymous namespace
+
+// Run in a child process by autosave/durability, which kills it
+TEST_CASE("autosave/durability_child" * doctest::skip()) {
+    temporary_config config("budget_test_durability", durability_values);
+
+    budget::set_server_running();
+
+    budget::data_handler<entry> entries("entries", "entries.data");
+    entries.next_id = 1;
+
+    for (size_t i = 0; i < durable_entries; ++i) {
+        entries.add(entry{0, "entry" + budget::to_string(i)});
+    }
+
+    std::ofstream(config.folder / "ready") << "ready" << std::endl;
+
+    std::this_thread::sleep_for(std::chrono::seconds(30));
+}
+
+TEST_CASE("autosave/durability") {
+    temporary_config config("budget_test_durability", durability_values);
+
+    std::filesystem::remove(config.folder / "entries.data");
+    std::filesystem::remove(config.folder / "ready");
+
+    // The server is simulated by another process, killed without any chance
+    // to flush its changes
+    std::string executable = std::filesystem::read_symlink("/proc/self/exe").string();
+    std::string no_skip    = "--no-skip";
+    std::string test_case  = "--test-case=autosave/durability_child";
+
+    char* arguments[] = {executable.data(), no_skip.data(), test_case.data(), nullptr};
+
+    pid_t child = 0;
+    REQUIRE(posix_spawn(&child, executable.c_str(), nullptr, nullptr, arguments, environ) == 0);
+
+    for (size_t i = 0; i < 100 && !std::filesystem::exists(config.folder / "ready"); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    // The changes are saved at most autosave_delay after the mutation
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+
+    budget::data_handler<entry> entries("entries", "entries.data");
+    entries.load();
+
+    REQUIRE(entries.size() == durable_entries);
+
+    for (size_t i = 0; i < durable_entries; ++i) {
+        FAST_CHECK_EQ(entries[i + 1].name, "entry" + budget::to_string(i));
+    }
+}
+
+TEST_CASE("autosave/coalesce") {
+    std::atomic<size_t> first_saves  = 0;
+    std::atomic<size_t> second_saves = 0;
+
+    int first  = 0;
+    int second = 0;
+
+    // Several changes of the same owner are saved once
+    for (size_t i = 0; i < 3; ++i) {
+        budget::schedule_save(&first, [&first_saves]() { ++first_saves; });
+    }
+
+    budget::schedule_save(&second, [&second_saves]() { ++second_saves; });
+    budget::cancel_save(&second);
+
+    budget::flush_saves();
+    budget::flush_saves();
+
+    FAST_CHECK_EQ(first_saves.load(), 1UL);
+    FAST_CHECK_EQ(second_saves.load(), 0UL);
+}
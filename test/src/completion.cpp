@@ -0,0 +1,63 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "test.hpp"
+#include "accounts.hpp"
+#include "completion.hpp"
+
+TEST_CASE("completion/prefix") {
+    budget::completion_index index({"Food", "Transport", "Fun", "food stamps", "Taxes"});
+
+    auto f = index.complete("F");
+
+    FAST_CHECK_EQ(f.size(), 2UL);
+    FAST_CHECK_EQ(f[0], std::string_view("Food"));
+    FAST_CHECK_EQ(f[1], std::string_view("Fun"));
+
+    auto food = index.complete_icase("FOOD");
+
+    FAST_CHECK_EQ(food.size(), 2UL);
+    FAST_CHECK_EQ(food[0], std::string_view("Food"));
+    FAST_CHECK_EQ(food[1], std::string_view("food stamps"));
+
+    FAST_CHECK_EQ(index.complete("").size(), 5UL);
+    FAST_CHECK_UNARY(index.complete("x").empty());
+    FAST_CHECK_UNARY(index.complete("Foods").empty());
+}
+
+TEST_CASE("completion/ranking") {
+    budget::completion_index index({"Food", "Fun", "Transport", "Fees"}, {2, 10, 0, 2});
+
+    // The most used first, the choices used as much keep their order
+    FAST_CHECK_EQ(index[0], std::string("Fun"));
+    FAST_CHECK_EQ(index[1], std::string("Food"));
+    FAST_CHECK_EQ(index[2], std::string("Fees"));
+    FAST_CHECK_EQ(index[3], std::string("Transport"));
+
+    auto f = index.complete("F");
+
+    FAST_CHECK_EQ(f.size(), 3UL);
+    FAST_CHECK_EQ(f[0], std::string_view("Fun"));
+    FAST_CHECK_EQ(f[1], std::string_view("Food"));
+    FAST_CHECK_EQ(f[2], std::string_view("Fees"));
+}
+
+TEST_CASE("completion/accounts") {
+    budget::account account;
+    account.name   = "Completed";
+    account.amount = budget::money(100);
+    account.since  = budget::date(2000, 1, 1);
+    account.until  = budget::date(2099, 12, 31);
+
+    const auto id = budget::add_account(std::move(account));
+
+    // The uses of deleted accounts are ignored
+    auto index = budget::account_names_completion({{id, 1000000}, {id + 1000000, 2000000}});
+
+    REQUIRE(!index.empty());
+    FAST_CHECK_EQ(index[0], std::string("Completed"));
+}
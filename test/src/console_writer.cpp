@@ -0,0 +1,136 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+#include "writer.hpp"
+
+namespace {
+
+struct table_case {
+    std::vector<std::string> columns;
+    std::vector<std::vector<std::string>> contents;
+    size_t groups = 1;
+    std::vector<size_t> lines;
+    size_t left = 0;
+    size_t foot = 0;
+};
+
+// The tables cover the colored and the success cells, the cells spanning
+// several lines, the underlined lines, the groups and the indentation
+std::vector<table_case> table_cases() {
+    std::vector<table_case> cases;
+
+    // A listing, the Edit column is removed and the cells are trimmed
+    cases.push_back({{"ID", "Date", "Name", "Amount", "Edit"},
+                     {{"1", "2024-01-02", "  Rent ", "::red-1000.00", "::edit::expenses::1"},
+                      {"12", "2024-01-15", "Salary", "::green5000.00", "::edit::expenses::12"},
+                      {"123", "2024-02-01", "Two\nlines", "0.00", "::edit::expenses::123"},
+                      {"", "", "Total", "::green4000.00", ""}},
+                     1, {}, 0, 1});
+
+    // The success cells, in the middle and in the last column
+    cases.push_back({{"Objective", "Success", "Status"},
+                     {{"Savings", "::success0", "::success42"},
+                      {"Expenses", "::success80", "::success100"},
+                      {"Long objective name", "::success150", "::red Bad"}}});
+
+    // The underlined lines, with the colors and the last column
+    cases.push_back({{"Month", "Income", "Expenses"},
+                     {{"January", "::green100.00", "::red50.00"},
+                      {"February", "::blue200.00", "25.00"},
+                      {"Total", "::green300.00", "::red75.00"}},
+                     1, {0, 2}});
+
+    // Two groups per column, indented
+    cases.push_back({{"Account", "2023", "2024"},
+                     {{"Main", "", "1.00", "::green+1", "22.00", "::red-2"},
+                      {"Savings account", "", "333.00", "", "4.00", "::success60"},
+                      {"Total", "", "334.00", "", "26.00", ""}},
+                     2, {2}, 4});
+
+    // A wide header over narrow groups
+    cases.push_back({{"A very long header", "B"},
+                     {{"x", "y", "z", "w"}},
+                     2});
+
+    // No header
+    cases.push_back({{},
+                     {{"Key", "::redValue"},
+                      {"Multi\nline key", "::green1.00"}},
+                     1, {1}, 2});
+
+    // No contents
+    cases.push_back({{"Only", "Columns"}, {}});
+
+    return cases;
+}
+
+// The output of each table, as rendered by the previous renderer, which wrote
+// each cell to the stream
+const std::vector<std::string> golden_tables = {
+    "\033[4;3047mID \033[0;3047m \033[4;3047mDate      \033[0;3047m \033[4;3047mName     \033[0;3047m \033[4;3047mAmount  \033[0;3047m\n"
+        "1   2024-01-02   Rent    \033[0;31m-1000.00\033[0;3047m\033[0;3047m\n"
+        "12  2024-01-15 Salary    \033[0;32m5000.00\033[0;3047m \033[0;3047m\n"
+        "123 2024-02-01 Two\n"
+        "lines 0.00    \033[0;3047m\n"
+        "               Total     \033[0;32m4000.00\033[0;3047m \033[0;3047m\n"
+        "\n"
+        "",
+    "\033[4;3047mObjective          \033[0;3047m \033[4;3047mSuccess     \033[0;3047m \033[4;3047mStatus      \033[0;3047m\n"
+        "Savings             \033[0;31m    0%\033[0m  \033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m   \033[0;33m   42%\033[0m  \033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m \033[0;3047m\n"
+        "Expenses            \033[0;32m   80%\033[0m  \033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m  \033[1;32m  100%\033[0m  \033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[0;3047m\n"
+        "Long objective name \033[1;32m  150%\033[0m  \033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m \033[0;31m Bad\033[0;3047m        \033[0;3047m\n"
+        "\n"
+        "",
+    "\033[4;3047mMonth   \033[0;3047m \033[4;3047mIncome      \033[0;3047m \033[4;3047mExpenses\033[0;3047m\n"
+        "\033[4;3047mJanuary \033[0;3047m \033[4;3047m\033[4;32m100.00\033[0;3047m      \033[0;3047m \033[4;3047m\033[4;31m50.00\033[0;3047m  \033[0;3047m\033[4;3047m \033[0;3047m\033[0;3047m\n"
+        "February \033[0;33m200.00\033[0;3047m 25.00   \033[0;3047m\n"
+        "\033[4;3047mTotal   \033[0;3047m \033[4;3047m\033[4;32m300.00\033[0;3047m      \033[0;3047m \033[4;3047m\033[4;31m75.00\033[0;3047m  \033[0;3047m\033[4;3047m \033[0;3047m\033[0;3047m\n"
+        "\n"
+        "",
+    "    \033[4;3047mAccount         \033[0;3047m \033[4;3047m2023     \033[0;3047m \033[4;3047m2024             \033[0;3047m\n"
+        "    Main             1.00   \033[0;32m+1\033[0;3047m 22.00 \033[0;31m-2\033[0;3047m         \033[0;3047m\n"
+        "    Savings account  333.00    4.00  \033[0;33m   60%\033[0m  \033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;42m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[1;41m   \033[0m\033[0;3047m\n"
+        "    \033[4;3047mTotal          \033[0;3047m \033[4;3047m\033[0;3047m \033[4;3047m334.00\033[0;3047m \033[4;3047m  \033[0;3047m \033[4;3047m26.00\033[0;3047m \033[4;3047m          \033[0;3047m \033[0;3047m\n"
+        "\n"
+        "",
+    "\033[4;3047mA very long header\033[0;3047m \033[4;3047mB  \033[0;3047m\n"
+        "x y                z w\033[0;3047m\n"
+        "\n"
+        "",
+    "  \n"
+        "  Key             \033[0;31mValue\033[0;3047m\033[0;3047m\n"
+        "  \033[4;3047mMulti\n"
+        "line key \033[0;3047m \033[4;3047m\033[4;32m1.00\033[0;3047m\033[0;3047m\033[4;3047m \033[0;3047m\033[0;3047m\n"
+        "\n"
+        "",
+    "\033[4;3047mOnly\033[0;3047m \033[4;3047mColumns\033[0;3047m\n"
+        "\n"
+        "",
+};
+
+} // end of anonymous namespace
+
+TEST_CASE("console_writer/display_table") {
+    auto cases = table_cases();
+
+    REQUIRE(cases.size() == golden_tables.size());
+
+    for (size_t i = 0; i < cases.size(); ++i) {
+        auto& c = cases[i];
+
+        std::stringstream out;
+        budget::console_writer w(out);
+        w.display_table(c.columns, c.contents, c.groups, c.lines, c.left, c.foot);
+
+        FAST_CHECK_EQ(out.str(), golden_tables[i]);
+    }
+}
@@ -0,0 +1,304 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <latch>
+#include <thread>
+#include <vector>
+
+#include "test.hpp"
+#include "test_config.hpp"
+#include "assets.hpp"
+#include "config.hpp"
+#include "currency.hpp"
+#include "date.hpp"
+#include "http.hpp"
+#include "utils.hpp"
+
+namespace {
+
+// A stand-in for the timeseries endpoint of the provider, with EUR as base
+// By default, it has the same rates every day. Otherwise, like the provider,
+// it publishes nothing on weekends and nothing yet for today, and the rate of
+// each currency is the day of the month, except for XXX that has no rates
+struct rates_stub_server {
+    httplib::Server server;
+    std::thread thread;
+    std::atomic<size_t> calls = 0;
+    std::chrono::milliseconds delay{0};
+    int port = 0;
+
+    explicit rates_stub_server(bool published_only = false) {
+        server.Get("/timeseries", [this, published_only](const httplib::Request& req, httplib::Response& res) {
+            ++calls;
+
+            std::this_thread::sleep_for(delay);
+
+            auto start = budget::date_from_string(req.get_param_value("start_date"));
+            auto end   = budget::date_from_string(req.get_param_value("end_date"));
+
+            std::string body = R"({"success":true,"timeseries":true,"base":"EUR","rates":{)";
+            bool first       = true;
+
+            for (auto d = start; d <= end; d += budget::days(1)) {
+                if (published_only && (d.day_of_the_week() >= 6 || d == budget::local_day())) {
+                    continue;
+                }
+
+                if (!first) {
+                    body += ',';
+                }
+
+                first = false;
+
+                if (!published_only) {
+                    body += std::format(R"("{}":{{"USD":1.25,"CHF":0.5}})", budget::date_to_string(d));
+                    continue;
+                }
+
+                const auto symbols = req.get_param_value("symbols");
+
+                std::string day_rates;
+                for (auto symbol : budget::splitv(symbols, ',')) {
+                    if (symbol == "XXX") {
+                        continue;
+                    }
+
+                    day_rates += std::format(R"({}"{}":{})", day_rates.empty() ? "" : ",", symbol, d.day().value);
+                }
+
+                body += std::format(R"("{}":{{{}}})", budget::date_to_string(d), day_rates);
+            }
+
+            body += "}}";
+
+            res.set_content(body, "application/json");
+        });
+
+        port   = server.bind_to_any_port("127.0.0.1");
+        thread = std::thread([this]() { server.listen_after_bind(); });
+
+        while (!server.is_running()) {
+            std::this_thread::yield();
+        }
+    }
+
+    ~rates_stub_server() {
+        server.stop();
+        thread.join();
+    }
+};
+
+} // end of anonymous namespace
+
+TEST_CASE("currency/pivot") {
+    rates_stub_server stub;
+
+    budget::internal_config_set("exchangeratesapi_key", "test");
+    budget::internal_config_set("exchangeratesapi_url", std::format("http://127.0.0.1:{}", stub.port));
+
+    const budget::date d(2020, 3, 4);
+
+    // A single call fills both legs of the cross rate
+    FAST_CHECK_EQ(budget::exchange_rate("USD", "CHF", d), 0.5 / 1.25);
+    FAST_CHECK_EQ(stub.calls.load(), 1UL);
+
+    // The reverse rate and the rates against the pivot are derived
+    FAST_CHECK_EQ(budget::exchange_rate("CHF", "USD", d), 1.25 / 0.5);
+    FAST_CHECK_EQ(budget::exchange_rate("USD", "EUR", d), 1.0 / 1.25);
+    FAST_CHECK_EQ(budget::exchange_rate("EUR", "CHF", d), 0.5);
+
+    // The other days of the window are part of the same call
+    FAST_CHECK_EQ(budget::exchange_rate("USD", "CHF", d + budget::days(1)), 0.5 / 1.25);
+    FAST_CHECK_EQ(stub.calls.load(), 1UL);
+
+    // The resolved currencies give the same rates as their codes
+    const auto usd = budget::resolve_currency("USD");
+    const auto chf = budget::resolve_currency("CHF");
+
+    FAST_CHECK_EQ(budget::exchange_rate(usd, chf, d), 0.5 / 1.25);
+    FAST_CHECK_EQ(budget::exchange_rate(usd, usd, d), 1.0);
+
+    // The default currency is resolved again once the configuration changes
+    const auto default_currency = budget::resolve_default_currency();
+
+    FAST_CHECK_EQ(default_currency, budget::resolve_currency(budget::get_default_currency()));
+
+    {
+        temporary_config config("budget_test_currency_default", {{"default_currency", "USD"}});
+
+        FAST_CHECK_EQ(budget::resolve_default_currency(), usd);
+        FAST_CHECK_EQ(budget::exchange_rate("CHF", d), 1.25 / 0.5);
+    }
+
+    FAST_CHECK_EQ(budget::resolve_default_currency(), default_currency);
+
+    budget::internal_config_remove("exchangeratesapi_key");
+    budget::internal_config_remove("exchangeratesapi_url");
+}
+
+TEST_CASE("currency/gaps") {
+    rates_stub_server stub(true);
+
+    budget::internal_config_set("exchangeratesapi_key", "test");
+    budget::internal_config_set("exchangeratesapi_url", std::format("http://127.0.0.1:{}", stub.port));
+
+    // The window of this Saturday starts on it, it's filled from the Friday
+    // before, which is fetched from the previous window
+    FAST_CHECK_EQ(budget::exchange_rate("EUR", "GBP", budget::date(2019, 7, 13)), 12.0);
+    FAST_CHECK_EQ(stub.calls.load(), 2UL);
+
+    FAST_CHECK_EQ(budget::exchange_rate("EUR", "GBP", budget::date(2019, 7, 14)), 12.0);
+    FAST_CHECK_EQ(budget::exchange_rate("EUR", "GBP", budget::date(2019, 7, 15)), 15.0);
+    FAST_CHECK_EQ(budget::exchange_rate("EUR", "GBP", budget::date(2019, 7, 12)), 12.0);
+    FAST_CHECK_EQ(stub.calls.load(), 2UL);
+
+    // Today is not published yet, it's filled from the last weekday
+    auto last = budget::local_day() - budget::days(1);
+    while (last.day_of_the_week() >= 6) {
+        last -= budget::days(1);
+    }
+
+    FAST_CHECK_EQ(budget::exchange_rate("EUR", "GBP", budget::local_day()), double(last.day().value));
+
+    budget::internal_config_remove("exchangeratesapi_key");
+    budget::internal_config_remove("exchangeratesapi_url");
+}
+
+TEST_CASE("currency/refresh") {
+    rates_stub_server stub(true);
+
+    budget::internal_config_set("exchangeratesapi_key", "test");
+    budget::internal_config_set("exchangeratesapi_url", std::format("http://127.0.0.1:{}", stub.port));
+    budget::internal_config_set("currency_refresh_interval", "0");
+
+    // A failing refresh must neither terminate the process nor prevent the
+    // next refreshes
+    budget::internal_config_set("currency_refresh_delay", "invalid");
+
+    budget::refresh_currency_cache();
+    budget::stop_currency_cache_refresh();
+
+    FAST_CHECK_EQ(stub.calls.load(), 0UL);
+
+    budget::internal_config_set("currency_refresh_delay", "0");
+
+    budget::refresh_currency_cache();
+
+    // The rate of the default currency for today is either missing or
+    // provisional, it is fetched by the refresh
+    for (size_t i = 0; i < 500 && !stub.calls.load(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    budget::stop_currency_cache_refresh();
+
+    FAST_CHECK_GT(stub.calls.load(), 0UL);
+
+    budget::internal_config_remove("exchangeratesapi_key");
+    budget::internal_config_remove("exchangeratesapi_url");
+    budget::internal_config_remove("currency_refresh_interval");
+    budget::internal_config_remove("currency_refresh_delay");
+}
+
+TEST_CASE("currency/binary_cache") {
+    temporary_config config("budget_test_currency");
+
+    std::filesystem::remove(config.folder / "currency.cache");
+    std::filesystem::remove(config.folder / "currency.cache.bin");
+
+    rates_stub_server stub(true);
+
+    budget::internal_config_set("exchangeratesapi_key", "test");
+    budget::internal_config_set("exchangeratesapi_url", std::format("http://127.0.0.1:{}", stub.port));
+
+    budget::exchange_rate("EUR", "JPY", budget::date(2018, 3, 6));
+    budget::save_currency_cache();
+
+    const auto binary_path = config.folder / "currency.cache.bin";
+    const auto saved       = std::filesystem::file_size(binary_path);
+
+    // The rates of another window are appended, not rewritten
+    budget::exchange_rate("EUR", "JPY", budget::date(2018, 9, 6));
+    budget::save_currency_cache();
+
+    FAST_CHECK_GT(std::filesystem::file_size(binary_path), saved);
+
+    std::ifstream binary(binary_path, std::ios::binary);
+    binary.seekg(std::streamoff(saved));
+
+    FAST_CHECK_EQ(char(binary.get()), 'R');
+
+    budget::internal_config_remove("exchangeratesapi_key");
+    budget::internal_config_remove("exchangeratesapi_url");
+}
+
+TEST_CASE("currency/negative") {
+    temporary_config config("budget_test_currency_negative");
+
+    std::filesystem::remove(config.folder / "currency.negative");
+
+    rates_stub_server stub(true);
+    stub.delay = std::chrono::milliseconds(200);
+
+    budget::internal_config_set("exchangeratesapi_key", "test");
+    budget::internal_config_set("exchangeratesapi_url", std::format("http://127.0.0.1:{}", stub.port));
+
+    const auto before = budget::currency_cache_stats();
+
+    // The threads all wait for the same fetch, which fails once
+    const size_t threads = 4;
+    std::latch start(threads);
+
+    std::vector<std::thread> pool;
+    for (size_t i = 0; i < threads; ++i) {
+        pool.emplace_back([&start]() {
+            start.arrive_and_wait();
+            FAST_CHECK_EQ(budget::exchange_rate("EUR", "XXX", budget::date(2019, 1, 16)), 1.0);
+        });
+    }
+
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    const auto calls = stub.calls.load();
+
+    // The other days of a failed window are not fetched again
+    FAST_CHECK_EQ(budget::exchange_rate("EUR", "XXX", budget::date(2019, 1, 17)), 1.0);
+    FAST_CHECK_EQ(stub.calls.load(), calls);
+
+    // The other windows are still fetched
+    FAST_CHECK_EQ(budget::exchange_rate("EUR", "XXX", budget::date(2019, 6, 17)), 1.0);
+    FAST_CHECK_GT(stub.calls.load(), calls);
+
+    const auto after = budget::currency_cache_stats();
+
+    FAST_CHECK_EQ(after.misses - before.misses, threads + 1);
+    FAST_CHECK_EQ(after.negative_hits - before.negative_hits, 1UL);
+
+    budget::save_currency_cache();
+
+    // The window has failed once, not once per thread
+    std::ifstream negatives(config.folder / "currency.negative");
+
+    size_t failures = 0;
+    std::string line;
+    while (std::getline(negatives, line)) {
+        if (line.starts_with("XXX/2019-01-14")) {
+            failures = budget::to_number<size_t>(line.substr(line.rfind(':') + 1));
+        }
+    }
+
+    FAST_CHECK_EQ(failures, 1UL);
+
+    budget::internal_config_remove("exchangeratesapi_key");
+    budget::internal_config_remove("exchangeratesapi_url");
+}
@@ -0,0 +1,58 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <vector>
+
+#include "test.hpp"
+#include "data_cache.hpp"
+#include "parallel.hpp"
+
+TEST_CASE("data_cache/concurrent") {
+    budget::expense expense;
+    expense.date    = budget::date(2018, 6, 1);
+    expense.name    = "cached";
+    expense.account = 1;
+    expense.amount  = budget::money(10);
+
+    budget::add_expense(std::move(expense));
+
+    budget::data_cache cache;
+
+    // All the readers see the same part, filled once
+    auto parts = budget::parallel_map(64, [&cache](size_t i) {
+        return i % 2 ? &cache.expenses() : &cache.sorted_expenses();
+    });
+
+    for (size_t i = 0; i < parts.size(); ++i) {
+        FAST_CHECK_EQ(parts[i], i % 2 ? &cache.expenses() : &cache.sorted_expenses());
+    }
+
+    FAST_CHECK_EQ(cache.expenses().size(), budget::all_expenses().size());
+    FAST_CHECK_UNARY(std::ranges::is_sorted(cache.sorted_expenses(), {}, [](const auto& value) { return value.date; }));
+}
+
+TEST_CASE("data_cache/once") {
+    budget::data_cache cache;
+
+    const auto wishes = cache.wishes().size();
+
+    budget::wish wish;
+    wish.date   = budget::date(2018, 6, 1);
+    wish.name   = "cached";
+    wish.amount = budget::money(10);
+    wish.paid   = false;
+
+    const auto id = budget::add_wish(std::move(wish));
+
+    // A part is filled only once per cache, even when it was empty
+    FAST_CHECK_EQ(cache.wishes().size(), wishes);
+
+    budget::data_cache fresh;
+    FAST_CHECK_EQ(fresh.wishes().size(), wishes + 1);
+
+    budget::wish_delete(id);
+}
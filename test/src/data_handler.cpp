@@ -0,0 +1,145 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <stdexcept>
+
+#include "test.hpp"
+#include "data.hpp"
+#include "date.hpp"
+
+namespace {
+
+struct entry {
+    size_t      id;
+    std::string name;
+
+    std::map<std::string, std::string, std::less<>> get_params() const {
+        return {{"input_id", budget::to_string(id)}, {"input_name", name}};
+    }
+
+    void load(budget::data_reader& reader) {
+        reader >> id;
+        reader >> name;
+    }
+
+    void save(budget::data_writer& writer) const {
+        writer << id;
+        writer << name;
+    }
+};
+
+struct dated_entry {
+    size_t       id;
+    budget::date date;
+
+    std::map<std::string, std::string, std::less<>> get_params() const {
+        return {{"input_id", budget::to_string(id)}, {"input_date", budget::to_string(date)}};
+    }
+
+    void load(budget::data_reader& reader) {
+        reader >> id;
+        reader >> date;
+    }
+
+    void save(budget::data_writer& writer) const {
+        writer << id;
+        writer << date;
+    }
+};
+
+} // end of anonymous namespace
+
+TEST_CASE("data_handler/batch") {
+    budget::data_handler<entry> entries("entries", "entries.data");
+    entries.next_id = 1;
+
+    {
+        auto batch = entries.begin_batch();
+
+        batch.add(entry{0, "first"});
+        batch.add(entry{0, "second"});
+        batch.edit(entry{1, "edited"});
+
+        // Nothing is marked as changed before the commit
+        FAST_CHECK_UNARY(!entries.is_changed());
+
+        batch.commit();
+    }
+
+    FAST_CHECK_UNARY(entries.is_changed());
+    FAST_CHECK_EQ(entries.size(), 2UL);
+    FAST_CHECK_EQ(entries[1].name, std::string("edited"));
+}
+
+TEST_CASE("data_handler/batch_rollback") {
+    budget::data_handler<entry> entries("entries", "entries.data");
+    entries.next_id = 1;
+
+    entries.add(entry{0, "first"});
+
+    auto mutate = [&entries]() {
+        auto batch = entries.begin_batch();
+
+        batch.add(entry{0, "second"});
+        batch.remove(1);
+
+        throw std::runtime_error("failed");
+    };
+
+    REQUIRE_THROWS_AS(mutate(), std::runtime_error);
+
+    FAST_CHECK_EQ(entries.size(), 1UL);
+    FAST_CHECK_EQ(entries[1].name, std::string("first"));
+    FAST_CHECK_EQ(entries.next_id, 2UL);
+}
+
+TEST_CASE("data_handler/batch_remove_missing") {
+    budget::data_handler<entry> entries("entries", "entries.data");
+    entries.next_id = 1;
+
+    {
+        auto batch = entries.begin_batch();
+
+        // Removing an unknown entry changes nothing
+        FAST_CHECK_UNARY(!batch.remove(42));
+
+        batch.commit();
+    }
+
+    FAST_CHECK_UNARY(!entries.is_changed());
+}
+
+TEST_CASE("data_handler/window") {
+    budget::data_handler<dated_entry> entries("entries", "entries.data");
+    entries.next_id = 1;
+
+    entries.add(dated_entry{0, budget::date(2020, 3, 1)});
+    entries.add(dated_entry{0, budget::date(2020, 1, 1)});
+    entries.add(dated_entry{0, budget::date(2020, 2, 1)});
+    entries.add(dated_entry{0, budget::date(2020, 3, 1)});
+
+    // Newest first, the same date is ordered by id
+    auto first = entries.window({.limit = 2});
+
+    FAST_CHECK_EQ(first.size(), 2UL);
+    FAST_CHECK_EQ(first[0].id, 4UL);
+    FAST_CHECK_EQ(first[1].id, 1UL);
+
+    auto second = entries.window({.limit = 2, .offset = 2});
+
+    FAST_CHECK_EQ(second.size(), 2UL);
+    FAST_CHECK_EQ(second[0].id, 3UL);
+    FAST_CHECK_EQ(second[1].id, 2UL);
+
+    auto since = entries.window({.offset = 1, .since = budget::date(2020, 2, 1)});
+
+    FAST_CHECK_EQ(since.size(), 2UL);
+    FAST_CHECK_EQ(since[0].id, 1UL);
+    FAST_CHECK_EQ(since[1].id, 3UL);
+
+    FAST_CHECK_UNARY(entries.window({.limit = 2, .offset = 10}).empty());
+}
@@ -0,0 +1,49 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "test.hpp"
+#include "config.hpp"
+#include "date.hpp"
+#include "market_calendar.hpp"
+
+TEST_CASE("market_calendar/weekends") {
+    FAST_CHECK_UNARY(budget::is_trading_day(budget::date(2024, 12, 27)));
+    FAST_CHECK_UNARY(!budget::is_trading_day(budget::date(2024, 12, 28)));
+    FAST_CHECK_UNARY(!budget::is_trading_day(budget::date(2024, 12, 29)));
+    FAST_CHECK_UNARY(budget::is_trading_day(budget::date(2024, 12, 30)));
+
+    FAST_CHECK_EQ(budget::last_trading_day(budget::date(2024, 12, 29)), budget::date(2024, 12, 27));
+    FAST_CHECK_EQ(budget::last_trading_day(budget::date(2024, 12, 30)), budget::date(2024, 12, 30));
+}
+
+TEST_CASE("market_calendar/holidays") {
+    // Both specific and yearly holidays, the invalid ones are ignored
+    budget::internal_config_set("market_holidays", "2024-12-25,01-01,invalid,2024-07-04");
+
+    FAST_CHECK_UNARY(!budget::is_trading_day(budget::date(2024, 12, 25)));
+    FAST_CHECK_UNARY(!budget::is_trading_day(budget::date(2024, 7, 4)));
+    FAST_CHECK_UNARY(budget::is_trading_day(budget::date(2024, 12, 24)));
+
+    // A specific holiday is only for its year
+    FAST_CHECK_UNARY(budget::is_trading_day(budget::date(2025, 12, 25)));
+
+    // A yearly holiday is for every year
+    FAST_CHECK_UNARY(!budget::is_trading_day(budget::date(2025, 1, 1)));
+    FAST_CHECK_UNARY(!budget::is_trading_day(budget::date(2026, 1, 1)));
+
+    FAST_CHECK_EQ(budget::last_trading_day(budget::date(2024, 12, 25)), budget::date(2024, 12, 24));
+    FAST_CHECK_EQ(budget::last_trading_day(budget::date(2025, 1, 1)), budget::date(2024, 12, 31));
+    FAST_CHECK_EQ(budget::last_trading_day(budget::date(2026, 1, 1)), budget::date(2025, 12, 31));
+
+    // A yearly holiday on a weekend
+    FAST_CHECK_EQ(budget::last_trading_day(budget::date(2028, 1, 2)), budget::date(2027, 12, 31));
+
+    // The holidays follow the configuration
+    budget::internal_config_remove("market_holidays");
+
+    FAST_CHECK_UNARY(budget::is_trading_day(budget::date(2024, 12, 25)));
+}
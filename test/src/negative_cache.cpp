@@ -0,0 +1,126 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "test.hpp"
+#include "test_config.hpp"
+#include "negative_cache.hpp"
+#include "utils.hpp"
+
+namespace {
+
+struct negative_entry {
+    int64_t expiry;
+    size_t failures;
+};
+
+// Read back the entries saved by a negative cache
+std::map<std::string, negative_entry> saved_entries(const std::filesystem::path& path) {
+    std::map<std::string, negative_entry> entries;
+
+    std::ifstream file(path);
+
+    std::string line;
+    while (std::getline(file, line)) {
+        auto parts = budget::split(line, ':');
+
+        if (parts.size() == 3) {
+            entries[parts[0]] = {budget::to_number<int64_t>(parts[1]), budget::to_number<size_t>(parts[2])};
+        }
+    }
+
+    return entries;
+}
+
+int64_t now_seconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // end of anonymous namespace
+
+TEST_CASE("negative_cache/backoff") {
+    temporary_config config("budget_test_negative_cache");
+
+    std::filesystem::remove(config.folder / "test.negative");
+
+    budget::internal_config_set("negative_cache_delay", "1");
+
+    budget::negative_cache cache("test.negative");
+
+    FAST_CHECK_UNARY(!cache.contains("A"));
+
+    // The delay doubles with each consecutive failure
+    cache.failure("A");
+    cache.failure("A");
+    cache.failure("A");
+    cache.failure("B");
+
+    FAST_CHECK_UNARY(cache.contains("A"));
+    FAST_CHECK_UNARY(cache.contains("B"));
+
+    // A success forgets the failures
+    cache.success("B");
+
+    FAST_CHECK_UNARY(!cache.contains("B"));
+
+    cache.save();
+
+    const auto now     = now_seconds();
+    const auto entries = saved_entries(config.folder / "test.negative");
+
+    REQUIRE(entries.contains("A"));
+    FAST_CHECK_UNARY(!entries.contains("B"));
+
+    FAST_CHECK_EQ(entries.at("A").failures, 3UL);
+    FAST_CHECK_GT(entries.at("A").expiry, now + 4 * 60 - 10);
+    FAST_CHECK_LE(entries.at("A").expiry, now + 4 * 60);
+
+    // The entries survive a restart
+    budget::negative_cache loaded("test.negative");
+    loaded.load();
+
+    FAST_CHECK_UNARY(loaded.contains("A"));
+    FAST_CHECK_UNARY(!loaded.contains("B"));
+
+    budget::internal_config_remove("negative_cache_delay");
+}
+
+TEST_CASE("negative_cache/retention") {
+    temporary_config config("budget_test_negative_cache");
+
+    const auto now = now_seconds();
+
+    {
+        std::ofstream file(config.folder / "retention.negative");
+        file << "old:" << now - 8 * 24 * 3600 << ":5" << std::endl;
+        file << "recent:" << now - 3600 << ":2" << std::endl;
+        file << "active:" << now + 3600 << ":1" << std::endl;
+    }
+
+    budget::negative_cache cache("retention.negative");
+    cache.load();
+
+    FAST_CHECK_UNARY(!cache.contains("old"));
+    FAST_CHECK_UNARY(!cache.contains("recent"));
+    FAST_CHECK_UNARY(cache.contains("active"));
+
+    // The entries expired long ago are dropped from the file, the recently
+    // expired ones are kept for their number of failures
+    cache.save();
+
+    const auto entries = saved_entries(config.folder / "retention.negative");
+
+    FAST_CHECK_UNARY(!entries.contains("old"));
+    REQUIRE(entries.contains("recent"));
+    FAST_CHECK_EQ(entries.at("recent").failures, 2UL);
+    FAST_CHECK_UNARY(entries.contains("active"));
+}
@@ -0,0 +1,209 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+#include "accounts.hpp"
+#include "earnings.hpp"
+#include "expenses.hpp"
+#include "overview.hpp"
+#include "writer.hpp"
+
+namespace {
+
+using table = std::vector<std::vector<std::string>>;
+
+// A writer that only keeps the tables
+struct table_writer : budget::writer {
+    std::vector<std::vector<std::string>> columns;
+    std::vector<table> tables;
+
+    writer& operator<<(std::string_view) override { return *this; }
+    writer& operator<<(double) override { return *this; }
+    writer& operator<<(size_t) override { return *this; }
+    writer& operator<<(long) override { return *this; }
+    writer& operator<<(int) override { return *this; }
+    writer& operator<<(unsigned) override { return *this; }
+
+    writer& operator<<(const budget::money&) override { return *this; }
+    writer& operator<<(const budget::year&) override { return *this; }
+    writer& operator<<(const budget::month&) override { return *this; }
+    writer& operator<<(const budget::day&) override { return *this; }
+
+    writer& operator<<(const budget::end_of_line_t&) override { return *this; }
+    writer& operator<<(const budget::p_begin_t&) override { return *this; }
+    writer& operator<<(const budget::p_end_t&) override { return *this; }
+    writer& operator<<(const budget::title_begin_t&) override { return *this; }
+    writer& operator<<(const budget::title_end_t&) override { return *this; }
+
+    bool is_web() override { return false; }
+
+    void display_table(std::vector<std::string>& table_columns, std::vector<std::vector<std::string>>& contents,
+                       size_t /*groups*/, std::vector<size_t> /*lines*/, size_t /*left*/, size_t /*foot*/) override {
+        columns.push_back(table_columns);
+        tables.push_back(contents);
+    }
+
+    void display_graph(std::string_view /*title*/, std::vector<std::string>& /*categories*/,
+                       std::vector<std::string> /*series_names*/, std::vector<std::vector<float>>& /*series_values*/) override {}
+};
+
+struct golden_column {
+    std::string account;
+    table items;         // The name, the amount and the last cell of each group
+    std::string total;
+    std::string total_last; // The cell after the total, only set by some overviews
+};
+
+// Check one column of an aggregate table, by name of account
+void check_column(const table_writer& w, size_t t, const golden_column& golden) {
+    REQUIRE(t < w.tables.size());
+
+    const auto& columns  = w.columns[t];
+    const auto& contents = w.tables[t];
+
+    auto it = std::ranges::find(columns, golden.account);
+    REQUIRE(it != columns.end());
+
+    const size_t c = it - columns.begin();
+
+    // The groups are followed by an empty line and the total line
+    REQUIRE(contents.size() >= golden.items.size() + 2);
+
+    for (size_t row = 0; row < golden.items.size(); ++row) {
+        FAST_CHECK_EQ(contents[row][c * 3], golden.items[row][0]);
+        FAST_CHECK_EQ(contents[row][c * 3 + 1], golden.items[row][1]);
+        FAST_CHECK_EQ(contents[row][c * 3 + 2], golden.items[row][2]);
+    }
+
+    if (golden.items.size() < contents.size() - 2) {
+        FAST_CHECK_EQ(contents[golden.items.size()][c * 3], std::string());
+    }
+
+    FAST_CHECK_EQ(contents.back()[0], std::string("Total"));
+    FAST_CHECK_EQ(contents.back()[c * 3 + 1], golden.total);
+    FAST_CHECK_EQ(contents.back()[c * 3 + 2], golden.total_last);
+}
+
+void add_golden_expense(size_t account, budget::date date, const std::string& name, long amount) {
+    budget::expense expense;
+    expense.account = account;
+    expense.date    = date;
+    expense.name    = name;
+    expense.amount  = budget::money(amount);
+
+    budget::add_expense(std::move(expense));
+}
+
+// A fixed dataset, in 2019, that no other test uses. The expected tables were
+// derived from the aggregation that used nested hash maps of names.
+void add_golden_dataset() {
+    static bool added = false;
+
+    if (added) {
+        return;
+    }
+
+    added = true;
+
+    auto add_golden_account = [](const std::string& name) {
+        budget::account account;
+        account.name   = name;
+        account.amount = budget::money(1000);
+        account.since  = budget::date(2000, 1, 1);
+        account.until  = budget::date(2099, 12, 31);
+
+        return budget::add_account(std::move(account));
+    };
+
+    const auto a = add_golden_account("Golden A");
+    const auto b = add_golden_account("Golden B");
+
+    add_golden_expense(a, {2019, 3, 1}, "Rent", 800);
+    add_golden_expense(a, {2019, 3, 5}, "Food/Groceries", 100);
+    add_golden_expense(b, {2019, 3, 15}, "Books", 40);
+    add_golden_expense(a, {2019, 3, 10}, "Food/Restaurant", 50);
+    add_golden_expense(b, {2019, 3, 20}, "Games/PC", 60);
+    add_golden_expense(a, {2019, 4, 1}, "rent ", 200);
+    add_golden_expense(a, {2019, 4, 2}, "Transport", 30);
+    add_golden_expense(b, {2019, 5, 1}, "Games/Console", 300);
+
+    budget::earning earning;
+    earning.account = a;
+    earning.date    = {2019, 3, 25};
+    earning.name    = "Salary";
+    earning.amount  = budget::money(5000);
+
+    budget::add_earning(std::move(earning));
+}
+
+} // end of anonymous namespace
+
+TEST_CASE("overview/aggregate_year") {
+    add_golden_dataset();
+
+    table_writer w;
+    budget::aggregate_year_overview(w, false, false, "/", budget::year(2019));
+
+    REQUIRE(w.tables.size() == 2);
+
+    check_column(w, 0, {"Golden A", {{"Rent", "1000.00", "63.29%"}, {"Food", "150.00", "9.49%"}, {"Transport", "30.00", "1.90%"}}, "1180.00", "74.68%"});
+    check_column(w, 0, {"Golden B", {{"Games", "360.00", "22.78%"}, {"Books", "40.00", "2.53%"}}, "400.00", "25.32%"});
+
+    check_column(w, 1, {"Golden A", {{"Salary", "5000.00", "100.00%"}}, "5000.00", "100.00%"});
+    check_column(w, 1, {"Golden B", {}, "0.00", "0.00%"});
+}
+
+TEST_CASE("overview/aggregate_year_month") {
+    add_golden_dataset();
+
+    table_writer w;
+    budget::aggregate_year_month_overview(w, false, false, "/", budget::year(2019));
+
+    REQUIRE(w.tables.size() == 2);
+
+    // The data starts in March, the mean is over ten months
+    check_column(w, 0, {"Golden A", {{"Rent", "1000.00", "100.00"}, {"Food", "150.00", "15.00"}, {"Transport", "30.00", "3.00"}}, "1180.00", ""});
+    check_column(w, 0, {"Golden B", {{"Games", "360.00", "36.00"}, {"Books", "40.00", "4.00"}}, "400.00", ""});
+
+    check_column(w, 1, {"Golden A", {{"Salary", "5000.00", "500.00"}}, "5000.00", ""});
+}
+
+TEST_CASE("overview/aggregate_year_fv") {
+    add_golden_dataset();
+
+    table_writer w;
+    budget::aggregate_year_fv_overview(w, false, false, "/", budget::year(2019));
+
+    REQUIRE(w.tables.size() == 2);
+
+    check_column(w, 0, {"Golden A", {{"Rent", "1000.00", "14206.74"}, {"Food", "150.00", "2130.97"}, {"Transport", "30.00", "426.15"}}, "1180.00", ""});
+    check_column(w, 0, {"Golden B", {{"Games", "360.00", "5114.41"}, {"Books", "40.00", "568.24"}}, "400.00", ""});
+
+    check_column(w, 1, {"Golden A", {{"Salary", "5000.00", "71033.89"}}, "5000.00", ""});
+}
+
+TEST_CASE("overview/aggregate_month") {
+    add_golden_dataset();
+
+    table_writer w;
+    budget::aggregate_month_overview(w, false, false, "/", budget::month(3), budget::year(2019));
+
+    REQUIRE(w.tables.size() == 2);
+
+    check_column(w, 0, {"Golden A", {{"Rent", "800.00", "76.19%"}, {"Food", "150.00", "14.29%"}}, "950.00", "90.48%"});
+    check_column(w, 0, {"Golden B", {{"Games", "60.00", "5.71%"}, {"Books", "40.00", "3.81%"}}, "100.00", "9.52%"});
+
+    // Without the groups, each name is its own group
+    table_writer ungrouped;
+    budget::aggregate_month_overview(ungrouped, false, true, "/", budget::month(3), budget::year(2019));
+
+    check_column(ungrouped, 0, {"Golden A", {{"Rent", "800.00", "76.19%"}, {"Food/Groceries", "100.00", "9.52%"}, {"Food/Restaurant", "50.00", "4.76%"}}, "950.00", "90.48%"});
+}
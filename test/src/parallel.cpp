@@ -0,0 +1,52 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "test.hpp"
+#include "parallel.hpp"
+
+TEST_CASE("parallel/map") {
+    std::vector<std::atomic<size_t>> runs(1000);
+
+    auto results = budget::parallel_map(runs.size(), [&runs](size_t i) {
+        ++runs[i];
+        return i * i;
+    });
+
+    REQUIRE(results.size() == runs.size());
+
+    // Each task is run once and the results are in the order of the tasks
+    for (size_t i = 0; i < runs.size(); ++i) {
+        FAST_CHECK_EQ(runs[i].load(), 1UL);
+        FAST_CHECK_EQ(results[i], i * i);
+    }
+
+    FAST_CHECK_UNARY(budget::parallel_map(0, [](size_t i) { return i; }).empty());
+}
+
+TEST_CASE("parallel/exception") {
+    std::atomic<size_t> runs = 0;
+
+    auto map = [&runs]() {
+        return budget::parallel_map(100, [&runs](size_t i) {
+            ++runs;
+
+            if (i == 42) {
+                throw std::runtime_error("failed");
+            }
+
+            return i;
+        });
+    };
+
+    // The other tasks are still run before the exception is rethrown
+    REQUIRE_THROWS_AS(map(), std::runtime_error);
+    FAST_CHECK_EQ(runs.load(), 100UL);
+}
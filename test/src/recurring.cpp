@@ -0,0 +1,127 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <filesystem>
+
+#include "test.hpp"
+#include "test_config.hpp"
+#include "accounts.hpp"
+#include "expenses.hpp"
+#include "recurring.hpp"
+
+namespace {
+
+budget::recurring make_recurring(const std::string& recurs) {
+    budget::recurring recurring;
+    recurring.name    = "Rent";
+    recurring.amount  = budget::money(1000);
+    recurring.recurs  = recurs;
+    recurring.account = "Recurring";
+    recurring.type    = "expense";
+    return recurring;
+}
+
+// The generated expenses of the test recurring, after the given date
+std::vector<budget::expense> generated_expenses(const budget::date& after) {
+    std::vector<budget::expense> generated;
+
+    for (auto& expense : budget::all_expenses()) {
+        if (expense.name == "Rent" && expense.date > after) {
+            generated.push_back(expense);
+        }
+    }
+
+    return generated;
+}
+
+} // end of anonymous namespace
+
+TEST_CASE("recurring/next_due_date") {
+    // The operations are always generated on the first of the month, whatever
+    // the day of the last operation
+    FAST_CHECK_EQ(budget::next_due_date(make_recurring("monthly"), {2024, 1, 31}), budget::date(2024, 2, 1));
+    FAST_CHECK_EQ(budget::next_due_date(make_recurring("monthly"), {2023, 1, 31}), budget::date(2023, 2, 1));
+    FAST_CHECK_EQ(budget::next_due_date(make_recurring("monthly"), {2024, 2, 29}), budget::date(2024, 3, 1));
+    FAST_CHECK_EQ(budget::next_due_date(make_recurring("monthly"), {2024, 12, 31}), budget::date(2025, 1, 1));
+    FAST_CHECK_EQ(budget::next_due_date(make_recurring("quarterly"), {2024, 11, 30}), budget::date(2025, 2, 1));
+    FAST_CHECK_EQ(budget::next_due_date(make_recurring("bi-yearly"), {2024, 8, 31}), budget::date(2025, 2, 1));
+    FAST_CHECK_EQ(budget::next_due_date(make_recurring("yearly"), {2024, 2, 29}), budget::date(2025, 1, 1));
+
+    // The incomplete last week of the year is skipped
+    FAST_CHECK_EQ(budget::next_due_date(make_recurring("weekly"), {2020, 12, 23}), budget::date(2021, 1, 5));
+}
+
+TEST_CASE("recurring/catch_up") {
+    temporary_config config("budget_test_recurring");
+
+    std::filesystem::remove(config.folder / "recurrings.schedule");
+
+    budget::account account;
+    account.name   = "Recurring";
+    account.amount = budget::money(5000);
+    account.since  = budget::date(2000, 1, 1);
+    account.until  = budget::date(2099, 12, 31);
+
+    const auto account_id = budget::add_account(std::move(account));
+
+    const auto recurring_id = budget::add_recurring(make_recurring("monthly"));
+
+    // The last operation was three months ago
+    const auto now   = budget::local_day();
+    const auto first = (now - budget::months(3)).start_of_month();
+
+    budget::expense expense;
+    expense.name    = "Rent";
+    expense.amount  = budget::money(1000);
+    expense.account = account_id;
+    expense.date    = first;
+
+    const auto expense_id = budget::add_expense(std::move(expense));
+
+    // Each of the missed months is generated, the current month only once it
+    // has started
+    const size_t missed = now.day() > budget::day(1) ? 3 : 2;
+
+    budget::check_for_recurrings();
+
+    auto generated = generated_expenses(first);
+
+    FAST_CHECK_EQ(generated.size(), missed);
+
+    for (auto& operation : generated) {
+        FAST_CHECK_EQ(operation.date.day(), budget::day(1));
+        FAST_CHECK_EQ(operation.account, account_id);
+    }
+
+    // The schedule persists across runs, the recurring is not due anymore,
+    // even if its operations disappear
+    REQUIRE(std::filesystem::exists(config.folder / "recurrings.schedule"));
+
+    for (auto& operation : generated) {
+        budget::expense_delete(operation.id);
+    }
+
+    budget::check_for_recurrings();
+
+    FAST_CHECK_EQ(generated_expenses(first).size(), 0UL);
+
+    // Without the schedule, the operations are caught up again
+    std::filesystem::remove(config.folder / "recurrings.schedule");
+
+    budget::check_for_recurrings();
+
+    generated = generated_expenses(first);
+
+    FAST_CHECK_EQ(generated.size(), missed);
+
+    for (auto& operation : generated) {
+        budget::expense_delete(operation.id);
+    }
+
+    budget::expense_delete(expense_id);
+    budget::recurring_delete(recurring_id);
+}
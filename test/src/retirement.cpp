@@ -34,3 +34,64 @@ TEST_CASE("retirement/fixed_fi_ratio/3") {
 
     FAST_CHECK_EQ(budget::fixed_fi_ratio(wrate, nw, expenses), 1.2);
 }
+
+TEST_CASE("retirement/projection") {
+    for (double monthly_return : {0.0, 0.004, 0.01, -0.002}) {
+        for (double monthly_savings : {0.0, 500.0, 2500.0}) {
+            const budget::projection projection{100000.0, monthly_return, monthly_savings};
+
+            for (double target : {50000.0, 150000.0, 1000000.0}) {
+                // The month by month reference, given up after a century
+                size_t months    = 0;
+                double net_worth = projection.net_worth;
+
+                while (net_worth < target && months < 1200) {
+                    net_worth = net_worth * (1.0 + monthly_return) + monthly_savings;
+                    ++months;
+                }
+
+                auto result = projection.months_to(target);
+
+                if (months == 1200) {
+                    FAST_CHECK_UNARY(!result || *result >= 1200);
+                } else {
+                    REQUIRE(result);
+                    FAST_CHECK_EQ(*result, months);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("retirement/simulate") {
+    budget::simulation_parameters parameters;
+    parameters.net_worth       = 100000.0;
+    parameters.monthly_savings = 2000.0;
+    parameters.target          = 1000000.0;
+    parameters.mean_return     = 0.05;
+    parameters.volatility      = 0.15;
+    parameters.years           = 20;
+    parameters.paths           = 1000;
+    parameters.seed            = 42;
+
+    // The same seed gives the same results
+    auto first  = budget::simulate_retirement(parameters);
+    auto second = budget::simulate_retirement(parameters);
+
+    FAST_CHECK_EQ(first.success, second.success);
+    FAST_CHECK_UNARY(first.net_worth == second.net_worth);
+    FAST_CHECK_EQ(first.net_worth.size(), 20UL);
+    FAST_CHECK_UNARY(first.net_worth[19][0] <= first.net_worth[19][1]);
+    FAST_CHECK_UNARY(first.net_worth[19][1] <= first.net_worth[19][2]);
+
+    // Without volatility, every path is the deterministic projection
+    parameters.volatility = 0.0;
+
+    auto fixed = budget::simulate_retirement(parameters);
+
+    const budget::projection projection{parameters.net_worth, parameters.mean_return / 12, parameters.monthly_savings};
+
+    FAST_CHECK_EQ(fixed.success, 1.0);
+    REQUIRE(fixed.months_to_target[1]);
+    FAST_CHECK_EQ(*fixed.months_to_target[1], *projection.months_to(parameters.target));
+}
@@ -0,0 +1,61 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include "test.hpp"
+#include "data_cache.hpp"
+#include "running_series.hpp"
+
+namespace {
+
+void add_test_expense(budget::date date, long amount, bool temporary = false) {
+    budget::expense expense;
+    expense.date      = date;
+    expense.name      = "expense";
+    expense.account   = 1;
+    expense.amount    = budget::money(amount);
+    expense.temporary = temporary;
+
+    budget::add_expense(std::move(expense));
+}
+
+} // end of anonymous namespace
+
+TEST_CASE("running_series/window") {
+    add_test_expense(budget::date(2020, 1, 15), 100);
+    add_test_expense(budget::date(2020, 6, 10), 50);
+    add_test_expense(budget::date(2020, 12, 20), 200);
+    add_test_expense(budget::date(2021, 1, 5), 30);
+
+    // The temporary expenses are not part of any metric
+    add_test_expense(budget::date(2020, 12, 25), 300, true);
+
+    budget::earning earning;
+    earning.date    = budget::date(2020, 12, 1);
+    earning.name    = "earning";
+    earning.account = 1;
+    earning.amount  = budget::money(1000);
+
+    budget::add_earning(std::move(earning));
+
+    budget::data_cache cache;
+    budget::running_series running(cache, budget::date(2021, 1, 20), budget::date(2021, 3, 20));
+
+    FAST_CHECK_EQ(running.size(), 3UL);
+    FAST_CHECK_EQ(running.date(2), budget::date(2021, 3, 20));
+
+    // The expenses go from the month before the same month of the previous year
+    FAST_CHECK_EQ(running.expenses(0), budget::money(350));
+    FAST_CHECK_EQ(running.expenses(1), budget::money(380));
+    FAST_CHECK_EQ(running.expenses(2), budget::money(280));
+
+    FAST_CHECK_EQ(running.income(0), budget::money(1000));
+    FAST_CHECK_EQ(running.income(2), budget::money(1000));
+
+    // Only the month of the earning has any income, and thus any savings
+    FAST_CHECK_EQ(running.savings_rate(0), doctest::Approx(0.8 / 12));
+    FAST_CHECK_EQ(running.savings_rate(2), doctest::Approx(0.8 / 12));
+}
@@ -0,0 +1,73 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test.hpp"
+#include "single_flight.hpp"
+
+using namespace std::string_literals;
+
+TEST_CASE("single_flight/concurrent") {
+    budget::single_flight<std::string, int> flights;
+
+    std::atomic<size_t> calls = 0;
+    std::atomic<int> sum      = 0;
+
+    const size_t threads = 8;
+    std::latch start(threads);
+
+    // The fetcher is slow enough for all the threads to arrive while it runs
+    auto fetcher = [&calls]() {
+        ++calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        return 42;
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t i = 0; i < threads; ++i) {
+        pool.emplace_back([&]() {
+            start.arrive_and_wait();
+            sum += flights.run("CHF"s, fetcher);
+        });
+    }
+
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    FAST_CHECK_EQ(calls.load(), 1UL);
+    FAST_CHECK_EQ(sum.load(), int(threads) * 42);
+}
+
+TEST_CASE("single_flight/sequential") {
+    budget::single_flight<std::string, int> flights;
+
+    size_t calls = 0;
+    auto fetcher = [&calls]() { return int(++calls); };
+
+    FAST_CHECK_EQ(flights.run("CHF"s, fetcher), 1);
+    FAST_CHECK_EQ(flights.run("CHF"s, fetcher), 2);
+    FAST_CHECK_EQ(flights.run("EUR"s, fetcher), 3);
+}
+
+TEST_CASE("single_flight/exception") {
+    budget::single_flight<std::string, int> flights;
+
+    auto fetcher = []() -> int { throw std::runtime_error("failed"); };
+
+    REQUIRE_THROWS_AS(flights.run("CHF"s, fetcher), std::runtime_error);
+
+    // The failed flight must not stay in flight
+    FAST_CHECK_EQ(flights.run("CHF"s, []() { return 1; }), 1);
+}
@@ -0,0 +1,97 @@
+//=======================================================================
+// Copyright (c) 2013-2020 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <sstream>
+
+#include "test.hpp"
+#include "accounts.hpp"
+#include "expenses.hpp"
+#include "trigram_index.hpp"
+#include "writer.hpp"
+
+TEST_CASE("trigram_index/search") {
+    budget::trigram_index index;
+
+    index.add("Groceries Migros");
+    index.add("Train ticket");
+    index.add("GROCERIES COOP");
+    index.add("Rent");
+
+    auto groceries = index.search("groceries");
+
+    FAST_CHECK_EQ(groceries.size(), 2UL);
+    FAST_CHECK_EQ(groceries[0], 0UL);
+    FAST_CHECK_EQ(groceries[1], 2UL);
+
+    // Short strings have no trigram
+    FAST_CHECK_EQ(index.search("en").size(), 1UL);
+    FAST_CHECK_EQ(index.search("").size(), 4UL);
+
+    // All the trigrams are present, but not in this order
+    FAST_CHECK_UNARY(index.search("ries Groc").empty());
+    FAST_CHECK_UNARY(index.search("bus").empty());
+}
+
+TEST_CASE("trigram_index/linear") {
+    std::vector<std::string> names;
+
+    for (size_t i = 0; i < 1000; ++i) {
+        names.push_back(std::format("Expense {} at shop {}", i * 7919 % 1000, i % 13));
+    }
+
+    budget::trigram_index index;
+
+    for (auto& name : names) {
+        index.add(name);
+    }
+
+    for (std::string_view needle : {"shop 1", "SHOP 12", "expense 99", "e 9", "at s", "shop 13"}) {
+        std::vector<size_t> expected;
+
+        for (size_t i = 0; i < names.size(); ++i) {
+            auto it = std::ranges::search(names[i], needle, [](char a, char b) { return std::tolower(a) == std::tolower(b); });
+
+            if (it) {
+                expected.push_back(i);
+            }
+        }
+
+        FAST_CHECK_UNARY(index.search(needle) == expected);
+    }
+}
+
+TEST_CASE("trigram_index/search_expenses") {
+    budget::account account;
+    account.name   = "Searched";
+    account.amount = budget::money(100);
+    account.since  = budget::date(2000, 1, 1);
+    account.until  = budget::date(2099, 12, 31);
+
+    budget::expense expense;
+    expense.account       = budget::add_account(std::move(account));
+    expense.date          = budget::date(2017, 2, 3);
+    expense.name          = "Xylophone";
+    expense.original_name = "ACME*MUSIC 4242";
+    expense.amount        = budget::money(250);
+
+    const auto id = budget::add_expense(std::move(expense));
+
+    // The expenses are found by name and by original name
+    for (auto search : {"xyloph", "acme*music", "4242"}) {
+        std::stringstream out;
+        budget::console_writer w(out);
+
+        budget::search_expenses(search, w);
+
+        FAST_CHECK_NE(out.str().find("Xylophone"), std::string::npos);
+    }
+
+    budget::expense_delete(id);
+}